@@ -8,27 +8,131 @@
 
 #include <stb_image.h>
 
+void App::start_prefetch() {
+    startup_start_time = std::chrono::high_resolution_clock::now();
+    startup_checkpoint = startup_start_time;
+
+    uint32_t worker_count = WORKER_THREAD_COUNT;
+    if (worker_count == 0)
+        worker_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    thread_pool.create(worker_count);
+
+    prefetch.vert_code = thread_pool.submit([]() { return read_file("vert.spv"); });
+    prefetch.frag_code = thread_pool.submit([]() { return read_file("frag.spv"); });
+#ifdef BIND_SAMPLE_TEXTURE
+    prefetch.tex_data = thread_pool.submit([this]() { return load_img_data(tex_path); });
+#endif
+    if (mesh_paths.empty())
+        prefetch.meshes.push_back(thread_pool.submit([this]() { return load_mesh(""); }));
+    for (const auto &path: mesh_paths)
+        prefetch.meshes.push_back(thread_pool.submit([this, path]() { return load_mesh(path); }));
+}
+
+void App::end_startup_stage(const char *name) {
+    auto now = std::chrono::high_resolution_clock::now();
+    startup_stages.push_back({name, std::chrono::duration<double, std::milli>(now - startup_checkpoint).count()});
+    startup_checkpoint = now;
+}
+
+VCW_ImageData App::load_img_data(const std::string &path) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    if (ext == ".ktx2")
+        return load_ktx2(path);
+    if (ext == ".dds")
+        return load_dds(path);
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    int width, height, channels;
+    stbi_uc *pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+
+    if (!pixels)
+        throw std::runtime_error("failed to load texture image.");
+
+    VCW_ImageData img_data;
+    img_data.format = VK_FORMAT_R8G8B8A8_SRGB;
+    img_data.width = static_cast<uint32_t>(width);
+    img_data.height = static_cast<uint32_t>(height);
+    img_data.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+
+    stbi_image_free(pixels);
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    img_data.load_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+
+    return img_data;
+}
+
+// the detail levels are generated here as well, still on the loading thread
+VCW_Mesh App::load_mesh(const std::string &path) {
+    VCW_Mesh mesh;
+    if (path.empty()) {
+#ifdef CUBE_DATA
+        mesh = VCW_Mesh(CUBE_VERTICES, CUBE_INDICES);
+#elif defined(PLATE_DATA)
+        mesh = VCW_Mesh(PLATE_VERTICES, PLATE_INDICES);
+#elif defined(SCREEN_QUAD_DATA)
+        mesh = VCW_Mesh(SCREEN_QUAD_VERTICES, SCREEN_QUAD_INDICES);
+#else
+        mesh = VCW_Mesh(TRIANGLE_VERTICES, TRIANGLE_INDICES);
+#endif
+    } else if (std::filesystem::path(path).extension() == ".vcwm") {
+        mesh = load_mesh_file(path);
+    } else {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        VCW_MeshData mesh_data = import_mesh(path);
+        optimize_mesh(mesh_data);
+        mesh = create_mesh(std::move(mesh_data));
+        auto end_time = std::chrono::high_resolution_clock::now();
+        mesh.load_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    }
+
+    generate_lods(mesh);
+    return mesh;
+}
+
 void App::init_app() {
     //
     // vulkan core initialization
     //
     create_inst();
     setup_debug_msg();
-    create_surf();
+    if (!headless)
+        create_surf();
+    end_startup_stage("instance");
 
     pick_phy_dev();
     create_dev();
+    end_startup_stage("device");
 
-    create_swap();
+    if (headless)
+        create_headless_targets();
+    else
+        create_swap();
+    end_startup_stage("swapchain");
 
     //
     // pipeline creation
     //
     create_rendp();
     create_desc_pool_layout();
+#ifdef BINDLESS
+    create_bindless();
+#endif
+#ifdef ENABLE_DYNAMIC_UNIFORM
+    create_dyn_unif_ring();
+#endif
+    create_pipe_cache();
+#ifdef GPU_DRIVEN
+    create_cull_pipe();
+#endif
     create_pipe();
+    create_frame_desc_template();
+    end_startup_stage("pipeline");
 
     create_cmd_pool();
+    create_sync();
+    create_staging_ring();
 
 #ifdef ENABLE_DEPTH_TESTING
     create_depth_resources();
@@ -37,89 +141,251 @@ void App::init_app() {
     create_tex_img();
 #endif
 
-#ifdef CUBE_DATA
-    create_vert_buf(CUBE_VERTICES);
-    create_index_buf(CUBE_INDICES);
-#elif defined(PLATE_DATA)
-    create_vert_buf(PLATE_VERTICES);
-    create_index_buf(PLATE_INDICES);
-#elif defined(SCREEN_QUAD_DATA)
-    create_vert_buf(SCREEN_QUAD_VERTICES);
-    create_index_buf(SCREEN_QUAD_INDICES);
-#else
-    create_vert_buf(TRIANGLE_VERTICES);
-    create_index_buf(TRIANGLE_INDICES);
+    // the store is sized for the startup meshes if they do not fit the default capacity
+    std::vector<VCW_Mesh> loaded_meshes;
+    VkDeviceSize vertex_bytes = 0;
+    VkDeviceSize index_bytes = 0;
+    for (auto &mesh_future: prefetch.meshes) {
+        loaded_meshes.push_back(mesh_future.get());
+        vertex_bytes += VCW_Layout::get_vertex_size() * loaded_meshes.back().vertices.size();
+        index_bytes += sizeof(uint32_t) * (loaded_meshes.back().get_index_count() + 1);
+        for (const auto &lod: loaded_meshes.back().lods)
+            index_bytes += sizeof(uint32_t) * lod.indices.size();
+    }
+    create_geometry_store(std::max<VkDeviceSize>(GEOMETRY_VERTEX_CAPACITY, vertex_bytes),
+                          std::max<VkDeviceSize>(GEOMETRY_INDEX_CAPACITY, index_bytes));
+
+    for (size_t i = 0; i < loaded_meshes.size(); i++) {
+        add_mesh(loaded_meshes[i]);
+        if (!mesh_paths.empty())
+            std::cout << "mesh " << mesh_paths[i] << ": " << loaded_meshes[i].vertices.size() << " vertices, "
+                      << loaded_meshes[i].get_index_count() / 3 << " triangles, "
+                      << loaded_meshes[i].index_size * 8 << " bit indices, "
+                      << VCW_Layout::get_vertex_size() * loaded_meshes[i].vertices.size() / 1024
+                      << " KiB of vertices (" << loaded_meshes[i].vertices.size_bytes() / 1024
+                      << " KiB as float position + uv), loaded in " << loaded_meshes[i].load_time << "ms" << std::endl;
+        if (!loaded_meshes[i].lods.empty()) {
+            std::cout << "  lods:";
+            for (const auto &lod: loaded_meshes[i].lods)
+                std::cout << " " << lod.indices.size() / 3 << " (error " << lod.error << ")";
+            std::cout << ", generated in " << loaded_meshes[i].lod_time << "ms" << std::endl;
+        }
+    }
+    if (meshlet_bench)
+        bench_meshlets(loaded_meshes);
+    // the streamed textures get objects of their own
+    if (!stream_dir.empty())
+        add_stream_dir(stream_dir);
+    create_objects(object_count);
+#ifdef ENABLE_DYNAMIC_UNIFORM
+    create_dyn_unif_buf(static_cast<uint32_t>(draws.size()));
+#endif
+#ifdef GPU_DRIVEN
+    create_instance_bufs();
 #endif
 #ifdef ENABLE_UNIFORM
     create_unif_bufs();
 #endif
-
+    // all static scene data goes out in one submission, the first frame is ordered behind it on the queue
+    flush_uploads();
+    end_startup_stage("resources");
+
+    if (headless) {
+        create_render_targets();
+        create_frame_bufs(render_targets);
+        create_readback_buf();
+    } else {
 #ifdef INTERMEDIATE_RENDER_TARGET
-    create_render_targets();
-    create_frame_bufs(render_targets);
+        create_render_targets();
+        create_frame_bufs(render_targets);
 #else
-    create_frame_bufs(swap_imgs);
+        create_frame_bufs(swap_imgs);
 #endif
+    }
+    create_frame_desc_allocs();
 #ifdef IMPL_IMGUI
-    create_desc_pool(MAX_FRAMES_IN_FLIGHT + IMGUI_DESCRIPTOR_COUNT);
-#else
-    create_desc_pool(MAX_FRAMES_IN_FLIGHT);
+    create_desc_pool(IMGUI_DESCRIPTOR_COUNT);
 #endif
-    write_desc_pool();
 
     create_cmd_bufs();
-    create_sync();
+    end_startup_stage("frame setup");
 
 #ifdef IMPL_IMGUI
-    init_imgui();
+    if (!headless)
+        init_imgui();
 #endif
+    end_startup_stage("imgui");
 
     create_query_pool(3);
 
 #ifdef USE_CAMERA
     cam.create_default_cam(render_extent);
+    // front / right are only set by rotation, headless never receives cursor input
+    cam.update_cam_rotation(0.0f, 0.0f);
 #endif
-}
 
-void App::create_vert_buf(const std::vector<Vertex> &vertices_dataset) {
-    vertices = vertices_dataset;
-    VkDeviceSize buf_size = sizeof(vertices[0]) * vertices.size();
+    auto end_time = std::chrono::high_resolution_clock::now();
+    startup_time = std::chrono::duration<double, std::milli>(end_time - startup_start_time).count();
 
-    VCW_Buffer staging_buf = create_buf(buf_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    std::cout << "startup: " << startup_time << "ms (";
+    for (size_t i = 0; i < startup_stages.size(); i++)
+        std::cout << (i > 0 ? ", " : "") << startup_stages[i].name << " " << startup_stages[i].time << "ms";
+    std::cout << ")" << std::endl;
 
-    cp_data_to_buf(&staging_buf, (void *) vertices.data());
+    if (desc_bench_iterations > 0)
+        bench_desc_updates(desc_bench_iterations);
+    if (cull_bench)
+        bench_scene_cull(thread_pool);
+}
 
-    vert_buf = create_buf(buf_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+// copies of the meshes in a cubic lattice around the origin, object i uses mesh i % meshes.size() and the objects
+// are told apart by their object data, with INSTANCING the objects of a mesh are the instances of its draw,
+// with STREAM_DRAWS every streamed texture adds a copy of mesh 0 at its place
+void App::create_objects(uint32_t count) {
+    uint32_t columns = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(count)) - 1e-6));
+    auto mesh_count = static_cast<uint32_t>(meshes.size());
+    draws.clear();
+    instances.clear();
+    instance_offsets.clear();
+    scene.clear();
+
+    auto get_model = [&](uint32_t i) {
+        glm::vec3 cell = glm::vec3(i % columns, i / columns % columns, i / columns / columns) -
+                         glm::vec3(static_cast<float>(columns - 1) / 2.0f);
+        return glm::translate(glm::mat4(1.0f), cell * OBJECT_SPACING);
+    };
+    // the objects spin around their origin, so the sphere is centered there and covers every rotation
+    auto add_to_scene = [&](const glm::mat4 &model, uint32_t mesh_index) {
+        const VCW_MeshRange &mesh = meshes[mesh_index];
+        scene.add_object(glm::vec3(model[3]), glm::length(glm::vec3(mesh.sphere)) + mesh.sphere.w, mesh_index);
+    };
+#ifdef STREAM_DRAWS
+    // scaled to the radius the wanted level of the texture is picked for
+    auto get_stream_model = [&](const VCW_StreamTexture &tex) {
+        const VCW_MeshRange &mesh = meshes[0];
+        float scale = tex.radius / (glm::length(glm::vec3(mesh.sphere)) + mesh.sphere.w);
+        return glm::scale(glm::translate(glm::mat4(1.0f), tex.pos), glm::vec3(scale));
+    };
+#endif
 
-    cp_buf(staging_buf, vert_buf);
+#ifdef INSTANCING
+    // instances are grouped by mesh, the scene follows the instance order, every detail level is a draw of its own
+    for (uint32_t m = 0; m < mesh_count; m++) {
+        const VCW_MeshRange &mesh = meshes[m];
+        instance_offsets.push_back(static_cast<uint32_t>(instances.size()));
+        for (uint32_t i = m; i < count; i += mesh_count) {
+            glm::mat4 model = get_model(i);
+            add_to_scene(model, m);
+            instances.push_back({model, tex_bindless_index});
+        }
+#ifdef STREAM_DRAWS
+        // the material is set every frame by bind_stream_texs
+        if (m == 0) {
+            for (auto &tex: stream_texs) {
+                glm::mat4 model = get_stream_model(tex);
+                scene.add_object(glm::vec3(model[3]), tex.radius, 0);
+                tex.object = static_cast<uint32_t>(instances.size());
+                instances.push_back({model, tex_bindless_index});
+            }
+        }
+#endif
 
-    clean_up_buf(staging_buf);
+        for (uint32_t lod = 0; lod < mesh.lod_count; lod++) {
+            VCW_DrawCmd draw{mesh.lods[lod].index_count, 0, mesh.lods[lod].first_index, mesh.vertex_offset,
+                             instance_offsets.back(), tex_bindless_index};
+            draw.mesh_index = m;
+            draw.lod = lod;
+            draws.push_back(draw);
+        }
+    }
+    instance_offsets.push_back(static_cast<uint32_t>(instances.size()));
+#else
+    for (uint32_t i = 0; i < count; i++) {
+        const VCW_MeshRange &mesh = meshes[i % mesh_count];
+        glm::mat4 model = get_model(i);
+        add_to_scene(model, i % mesh_count);
+
+        // the first instance is the object's index in the gpu driven instance buffer
+        VCW_DrawCmd draw{mesh.index_count, 1, mesh.first_index, mesh.vertex_offset, i, tex_bindless_index};
+        draw.model = model;
+        draw.mesh_index = i % mesh_count;
+        draws.push_back(draw);
+    }
+#ifdef STREAM_DRAWS
+    // the texture is set every frame by bind_stream_texs
+    for (auto &tex: stream_texs) {
+        const VCW_MeshRange &mesh = meshes[0];
+        auto i = static_cast<uint32_t>(draws.size());
+        glm::mat4 model = get_stream_model(tex);
+        scene.add_object(glm::vec3(model[3]), tex.radius, 0);
+        tex.object = i;
+
+        VCW_DrawCmd draw{mesh.index_count, 1, mesh.first_index, mesh.vertex_offset, i, tex_bindless_index};
+        draw.model = model;
+        draws.push_back(draw);
+    }
+#endif
+#endif
 }
 
-void App::create_index_buf(const std::vector<uint16_t> &indices_dataset) {
-    indices = indices_dataset;
-    VkDeviceSize buf_size = sizeof(indices[0]) * indices.size();
+// the device is idle, nothing in flight references the old objects
+void App::set_object_count(uint32_t count) {
+    object_count = count;
+    create_objects(count);
 
-    VCW_Buffer staging_buf = create_buf(buf_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+#ifdef ENABLE_DYNAMIC_UNIFORM
+    create_dyn_unif_buf(static_cast<uint32_t>(draws.size()));
+#endif
 
-    cp_data_to_buf(&staging_buf, (void *) indices.data());
+#ifdef GPU_DRIVEN
+    clean_up_buf(instance_buf);
+    clean_up_buf(indirect_buf);
+#ifdef MESHLETS
+    clean_up_buf(meshlet_buf);
+#endif
+    create_instance_bufs();
+#endif
+}
 
-    index_buf = create_buf(buf_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+// the transforms change every frame, so every frame region is written in full
+void App::update_instance_buf(uint32_t frame) {
+    if (instances.size() > instance_capacity) {
+        // frames in flight keep drawing from their region of the old buffer
+        if (instance_capacity > 0) {
+            VCW_Buffer old_buf = instance_vert_buf;
+            defer_deletion([this, old_buf]() { clean_up_buf(old_buf); });
+        }
 
-    cp_buf(staging_buf, index_buf);
+        instance_capacity = std::bit_ceil(static_cast<uint32_t>(instances.size()));
+        instance_vert_buf = create_buf(sizeof(VCW_InstanceData) * instance_capacity * frames_in_flight,
+                                       VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        map_buf(&instance_vert_buf);
+    }
 
-    clean_up_buf(staging_buf);
+    float angle = static_cast<float>(stats.frame_count) * 0.01f;
+    auto *p_dst = static_cast<VCW_InstanceData *>(instance_vert_buf.p_mapped_mem) + frame * instance_capacity;
+    // culled instances are left out, the visible ones of each draw are packed behind the previous draw's
+    uint32_t instance_count = 0;
+    for (size_t d = 0; d < draws.size(); d++) {
+        draws[d].first_instance = instance_count;
+        uint32_t mesh_index = draws[d].mesh_index;
+        for (uint32_t i = instance_offsets[mesh_index]; i < instance_offsets[mesh_index + 1]; i++) {
+            if (!scene.visible[i] || scene.lod[i] != draws[d].lod)
+                continue;
+            p_dst[instance_count++] = {glm::rotate(instances[i].model, angle, glm::vec3(0.0f, 1.0f, 0.0f)),
+                                       instances[i].material};
+        }
+        draws[d].instance_count = instance_count - draws[d].first_instance;
+    }
 }
 
 void App::create_unif_bufs() {
     VkDeviceSize buf_size = sizeof(VCW_Uniform);
-    unif_bufs.resize(MAX_FRAMES_IN_FLIGHT);
+    unif_bufs.resize(frames_in_flight);
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < frames_in_flight; i++) {
         unif_bufs[i] = create_buf(buf_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
@@ -128,37 +394,54 @@ void App::create_unif_bufs() {
 }
 
 void App::create_tex_img() {
-    int tex_width, tex_height, tex_channels;
-    stbi_uc *pixels = stbi_load("textures/texture.jpg", &tex_width, &tex_height, &tex_channels, STBI_rgb_alpha);
-    VkDeviceSize img_size = tex_width * tex_height * 4;
-
-    if (!pixels)
-        throw std::runtime_error("failed to load texture image.");
-
-    VCW_Buffer staging_buf = create_buf(img_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    VCW_ImageData tex_data = prefetch.tex_data.get();
+    VkFormat stored_format = tex_data.format;
+
+    // block compressed data is decoded on the cpu if the device cannot sample it
+    VkFormat format = find_supported_format({tex_data.format, get_decoded_format(tex_data.format)},
+                                            VK_IMAGE_TILING_OPTIMAL,
+                                            VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+                                            VK_FORMAT_FEATURE_TRANSFER_DST_BIT);
+    if (format != tex_data.format)
+        decode_bc(tex_data);
+
+    VkExtent2D extent = {tex_data.width, tex_data.height};
+
+    // a stored chain is uploaded as is, otherwise the chain is built on the gpu from the uploaded base level
+    VkImageUsageFlags mip_usage = 0;
+    uint32_t mip_levels = tex_data.mip_levels;
+    if (mip_levels == 1) {
+        mip_usage = get_mip_gen_usage(format);
+        mip_levels = tex_mips && mip_usage ? get_mip_count(extent) : 1;
+    } else if (!tex_mips) {
+        mip_levels = 1;
+    }
 
-    cp_data_to_buf(&staging_buf, pixels);
+    tex_img = create_img(extent, format, VK_IMAGE_TILING_OPTIMAL,
+                         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | mip_usage,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mip_levels, tex_data.array_layers,
+                         mip_levels > 1 && mip_usage ? get_mip_gen_flags(format) : 0);
 
-    stbi_image_free(pixels);
+    uint32_t data_levels = std::min(tex_data.mip_levels, mip_levels);
+    VkDeviceSize data_size = 0;
+    for (uint32_t level = 0; level < data_levels; level++)
+        data_size += get_level_size(format, extent.width, extent.height, level, tex_data.array_layers);
 
-    VkExtent2D extent = {(uint32_t) tex_width, (uint32_t) tex_height};
-    tex_img = create_img(extent, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
-                         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    upload_to_img(&tex_img, tex_data.pixels.data(), data_size, data_levels);
+    auto end_time = std::chrono::high_resolution_clock::now();
 
-    VkCommandBuffer cmd_buf = begin_single_time_cmd();
-    transition_img_layout(cmd_buf, &tex_img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                          VK_PIPELINE_STAGE_TRANSFER_BIT);
-    cp_buf_to_img(cmd_buf, staging_buf, tex_img, extent);
-    transition_img_layout(cmd_buf, &tex_img, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
-    end_single_time_cmd(cmd_buf);
+    std::cout << "texture: " << extent.width << "x" << extent.height << ", format " << format
+              << (format != stored_format ? " (decoded on the cpu)" : "") << ", " << mip_levels << " levels ("
+              << data_levels << " stored), " << tex_img.alloc.size / 1024 << " KiB, load "
+              << tex_data.load_time << "ms, staging "
+              << std::chrono::duration<double, std::milli>(end_time - start_time).count() << "ms" << std::endl;
 
     create_img_view(&tex_img, VK_IMAGE_ASPECT_COLOR_BIT);
     create_sampler(&tex_img, VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT);
-
-    clean_up_buf(staging_buf);
+#ifdef BINDLESS
+    tex_bindless_index = add_bindless_tex(tex_img);
+#endif
 }
 
 void App::create_depth_resources() {
@@ -194,26 +477,28 @@ void App::create_desc_pool_layout() {
     last_binding++;
 #endif
 
-    for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-        add_desc_set_layout(static_cast<uint32_t>(bindings.size()), bindings.data());
+    if (desc_update_mode == DESC_UPDATE_PUSH && !push_desc_supported) {
+        std::cout << "push descriptors not supported, using update templates" << std::endl;
+        desc_update_mode = DESC_UPDATE_TEMPLATE;
     }
+    // a template needs at least one entry
+    if (bindings.empty())
+        desc_update_mode = DESC_UPDATE_WRITES;
+
+    // every frame slot shares this layout, its sets come from the frame's pools
+    frame_desc_bindings = bindings;
+    frame_desc_set_layout = get_desc_set_layout(bindings, {}, desc_update_mode == DESC_UPDATE_PUSH
+                                                              ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR
+                                                              : 0);
 
-#ifdef ENABLE_UNIFORM
-    add_pool_size(MAX_FRAMES_IN_FLIGHT, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-#endif
-    uint32_t combined_img_samplers = 0;
-#ifdef BIND_SAMPLE_TEXTURE
-    combined_img_samplers += MAX_FRAMES_IN_FLIGHT;
-#endif
 #ifdef IMPL_IMGUI
-    combined_img_samplers += IMGUI_DESCRIPTOR_COUNT;
+    add_pool_size(IMGUI_DESCRIPTOR_COUNT, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 #endif
-    add_pool_size(combined_img_samplers, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 }
 
 void App::create_pipe() {
-    auto vert_code = read_file("vert.spv");
-    auto frag_code = read_file("frag.spv");
+    auto vert_code = prefetch.vert_code.get();
+    auto frag_code = prefetch.frag_code.get();
 
     VkShaderModule vert_module = create_shader_mod(vert_code);
     VkShaderModule frag_module = create_shader_mod(frag_code);
@@ -235,12 +520,19 @@ void App::create_pipe() {
     VkPipelineVertexInputStateCreateInfo vert_input_info{};
     vert_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-    auto binding_desc = Vertex::get_binding_desc();
-    auto attrib_descs = Vertex::get_attrib_descs();
+    constexpr auto vert_binding_descs = VCW_Layout::get_binding_descs();
+    constexpr auto vert_attrib_descs = VCW_Layout::get_attrib_descs();
+    std::vector<VkVertexInputBindingDescription> binding_descs(vert_binding_descs.begin(), vert_binding_descs.end());
+    std::vector<VkVertexInputAttributeDescription> attrib_descs(vert_attrib_descs.begin(), vert_attrib_descs.end());
+#ifdef INSTANCING
+    binding_descs.push_back(VCW_InstanceData::get_binding_desc());
+    auto instance_attrib_descs = VCW_InstanceData::get_attrib_descs();
+    attrib_descs.insert(attrib_descs.end(), instance_attrib_descs.begin(), instance_attrib_descs.end());
+#endif
 
-    vert_input_info.vertexBindingDescriptionCount = 1;
+    vert_input_info.vertexBindingDescriptionCount = static_cast<uint32_t>(binding_descs.size());
     vert_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attrib_descs.size());
-    vert_input_info.pVertexBindingDescriptions = &binding_desc;
+    vert_input_info.pVertexBindingDescriptions = binding_descs.data();
     vert_input_info.pVertexAttributeDescriptions = attrib_descs.data();
 
     VkPipelineInputAssemblyStateCreateInfo input_asm_info{};
@@ -312,10 +604,21 @@ void App::create_pipe() {
     push_const_range.size = sizeof(VCW_PushConstants);
 #endif
 
+    // the per frame sets share one layout in set 0, the bindless table is set 1
+    std::vector<VkDescriptorSetLayout> set_layouts = {frame_desc_set_layout};
+#ifdef BINDLESS
+    set_layouts.push_back(bindless_set_layout);
+#endif
+#ifdef ENABLE_DYNAMIC_UNIFORM
+    set_layouts.push_back(dyn_unif_set_layout);
+#elif defined(GPU_DRIVEN)
+    set_layouts.push_back(object_set_layout);
+#endif
+
     VkPipelineLayoutCreateInfo pipe_layout_info{};
     pipe_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipe_layout_info.setLayoutCount = static_cast<uint32_t>(desc_set_layouts.size());
-    pipe_layout_info.pSetLayouts = desc_set_layouts.data();
+    pipe_layout_info.setLayoutCount = static_cast<uint32_t>(set_layouts.size());
+    pipe_layout_info.pSetLayouts = set_layouts.data();
 #ifdef ENABLE_PUSH_CONSTANTS
     pipe_layout_info.pushConstantRangeCount = 1;
     pipe_layout_info.pPushConstantRanges = &push_const_range;
@@ -343,27 +646,88 @@ void App::create_pipe() {
     pipe_info.subpass = 0;
     pipe_info.basePipelineHandle = VK_NULL_HANDLE;
 
-    if (vkCreateGraphicsPipelines(dev, VK_NULL_HANDLE, 1, &pipe_info, nullptr, &pipe) != VK_SUCCESS)
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    if (vkCreateGraphicsPipelines(dev, pipe_cache, 1, &pipe_info, nullptr, &pipe) != VK_SUCCESS)
         throw std::runtime_error("failed to create graphics pipeline.");
 
+    auto end_time = std::chrono::high_resolution_clock::now();
+    pipe_create_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+
+    std::cout << "pipeline creation: " << pipe_create_time << "ms (" << (pipe_cache_warm ? "warm" : "cold")
+              << " cache)" << std::endl;
+
     vkDestroyShaderModule(dev, frag_module, nullptr);
     vkDestroyShaderModule(dev, vert_module, nullptr);
 }
 
-void App::write_desc_pool() {
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+// the push template is bound to the pipeline layout, so it is created after the pipeline
+void App::create_frame_desc_template() {
+    if (desc_update_mode == DESC_UPDATE_WRITES)
+        return;
+
+    frame_desc_template = create_desc_template(frame_desc_bindings, frame_desc_set_layout,
+                                               desc_update_mode == DESC_UPDATE_PUSH ? pipe_layout : VK_NULL_HANDLE);
+
+    size_t desc_count = 0;
+    for (const auto &binding: frame_desc_bindings)
+        desc_count += binding.descriptorCount;
+    frame_desc_data.assign(frames_in_flight, std::vector<VCW_DescInfo>(desc_count));
+}
+
+// the frame's pools were reset, the set is allocated and written again together with any queued writes
+void App::write_frame_desc_set(uint32_t frame) {
+    if (desc_update_mode == DESC_UPDATE_WRITES) {
+        desc_sets[frame] = alloc_frame_desc_set(frame, frame_desc_set_layout);
+
         uint32_t last_binding = 0;
 #ifdef ENABLE_UNIFORM
-        write_buf_desc_binding(unif_bufs[i], i, last_binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+        write_buf_desc_binding(unif_bufs[frame], desc_sets[frame], last_binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
         last_binding++;
 #endif
 #ifdef BIND_SAMPLE_TEXTURE
-        write_img_desc_binding(tex_img, i, last_binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        write_img_desc_binding(tex_img, desc_sets[frame], last_binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+#endif
+
+        flush_desc_writes();
+        return;
+    }
+
+    // every binding holds one descriptor, so the binding is the index into the packed data
+    std::vector<VCW_DescInfo> &desc_data = frame_desc_data[frame];
+    uint32_t last_binding = 0;
+#ifdef ENABLE_UNIFORM
+    desc_data[last_binding].buf = {unif_bufs[frame].buf, 0, unif_bufs[frame].size};
+    last_binding++;
+#endif
+#ifdef BIND_SAMPLE_TEXTURE
+    desc_data[last_binding].img = {tex_img.sampler, tex_img.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
 #endif
+
+    // pushed descriptors are recorded from the same data in record_draws
+    if (desc_update_mode == DESC_UPDATE_TEMPLATE) {
+        desc_sets[frame] = alloc_frame_desc_set(frame, frame_desc_set_layout);
+        vkUpdateDescriptorSetWithTemplate(dev, desc_sets[frame], frame_desc_template, desc_data.data());
     }
+
+    // bindless slots are still written as a batch
+    flush_desc_writes();
 }
 
 void App::update_bufs(uint32_t index_inflight_frame) {
+#ifdef USE_CAMERA
+    // planes are extracted once, large scenes are tested on all threads
+    bool culled = cpu_cull;
+#ifdef GPU_DRIVEN
+    culled &= !gpu_cull;
+#endif
+    if (culled)
+        scene.cull(cam.get_frustum_planes(), &thread_pool);
+    select_lods();
+#endif
+#ifdef STREAM_DRAWS
+    bind_stream_texs(index_inflight_frame);
+#endif
 #ifdef ENABLE_PUSH_CONSTANTS
     push_const.view_proj = cam.get_view_proj();
     push_const.res = {render_extent.width, render_extent.height};
@@ -373,6 +737,194 @@ void App::update_bufs(uint32_t index_inflight_frame) {
     ubo.data = cam.get_view_proj();
     memcpy(unif_bufs[index_inflight_frame].p_mapped_mem, &ubo, sizeof(ubo));
 #endif
+#ifdef INSTANCING
+    update_instance_buf(index_inflight_frame);
+#endif
+#ifdef ENABLE_DYNAMIC_UNIFORM
+    // a slice per draw, no allocation or descriptor, the objects spin so their data changes every frame
+    float angle = static_cast<float>(stats.frame_count) * 0.01f;
+    draw_unif_offsets.resize(draws.size());
+    for (size_t i = 0; i < draws.size(); i++) {
+        if (!scene.visible[i])
+            continue;
+        VCW_UniformSlice slice = alloc_dyn_unif(sizeof(VCW_ObjectUniform));
+        static_cast<VCW_ObjectUniform *>(slice.p_data)->model = glm::rotate(draws[i].model, angle,
+                                                                            glm::vec3(0.0f, 1.0f, 0.0f));
+        draw_unif_offsets[i] = slice.offset;
+    }
+#endif
+    stats.triangles = get_submitted_triangles();
+}
+
+// the distance is taken to the object's bounding sphere, so no part of it is closer than that
+void App::select_lods() {
+#ifdef GPU_DRIVEN
+    // the culling pass draws the full meshes
+    if (gpu_cull)
+        return;
+#endif
+    float pixel_scale = get_lod_pixel_scale(cam.fov, render_extent.height);
+    for (size_t i = 0; i < scene.size(); i++) {
+        if (!scene.visible[i])
+            continue;
+
+        const VCW_MeshRange &mesh = meshes[scene.mesh[i]];
+        uint32_t lod = 0;
+        if (lods) {
+            float distance = glm::length(glm::vec3(scene.center_x[i], scene.center_y[i], scene.center_z[i]) - cam.pos) -
+                             scene.radius[i];
+            lod = select_lod(std::span(mesh.lods.data(), mesh.lod_count), distance, pixel_scale, lod_pixel_error);
+        }
+        scene.lod[i] = static_cast<uint8_t>(lod);
+#ifndef INSTANCING
+        draws[i].lod = lod;
+        draws[i].index_count = mesh.lods[lod].index_count;
+        draws[i].first_index = mesh.lods[lod].first_index;
+#endif
+    }
+}
+
+uint64_t App::get_submitted_triangles() const {
+    uint64_t triangles = 0;
+    for (size_t i = 0; i < draws.size(); i++) {
+#ifdef INSTANCING
+        triangles += static_cast<uint64_t>(draws[i].index_count / 3) * draws[i].instance_count;
+#else
+        if (scene.visible[i])
+            triangles += draws[i].index_count / 3;
+#endif
+    }
+    return triangles;
+}
+
+void App::begin_secondary_cmd_buf(VkCommandBuffer cmd_buf, uint32_t img_index) {
+    VkCommandBufferInheritanceInfo inheritance_info{};
+    inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance_info.renderPass = rendp;
+    inheritance_info.subpass = 0;
+    inheritance_info.framebuffer = frame_bufs[img_index];
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance_info;
+
+    if (vkBeginCommandBuffer(cmd_buf, &begin_info) != VK_SUCCESS)
+        throw std::runtime_error("failed to begin recording secondary command buffer.");
+}
+
+// dynamic state is not inherited by secondaries, so every call binds the full state
+void App::record_draws(VkCommandBuffer cmd_buf, size_t first_draw, size_t draw_count) {
+    vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe);
+
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float) render_extent.width;
+    viewport.height = (float) render_extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(cmd_buf, 0, 1, &viewport);
+
+    VkRect2D scissor{};
+    scissor.offset = {0, 0};
+    scissor.extent = render_extent;
+    vkCmdSetScissor(cmd_buf, 0, 1, &scissor);
+
+    VkBuffer vert_bufs[] = {vert_buf.buf};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(cmd_buf, 0, 1, vert_bufs, offsets);
+#ifdef SPLIT_VERTEX_STREAMS
+    vkCmdBindVertexBuffers(cmd_buf, VERTEX_ATTRIB_BINDING, 1, &attrib_buf.buf, offsets);
+#endif
+#ifdef INSTANCING
+    VkDeviceSize instance_offset = sizeof(VCW_InstanceData) * instance_capacity * cur_frame;
+    vkCmdBindVertexBuffers(cmd_buf, 1, 1, &instance_vert_buf.buf, &instance_offset);
+#endif
+
+    // the index buffer is rebound only where the next mesh uses the other index type
+    VkIndexType index_type = meshes[0].index_type;
+    vkCmdBindIndexBuffer(cmd_buf, index_buf.buf, 0, index_type);
+#ifdef QUANTIZED_VERTICES
+    uint32_t dequant_mesh = UINT32_MAX;
+#endif
+
+    if (desc_update_mode == DESC_UPDATE_PUSH)
+        p_cmd_push_desc_template(cmd_buf, frame_desc_template, pipe_layout, 0, frame_desc_data[cur_frame].data());
+    else
+        vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe_layout, 0, 1,
+                                &desc_sets[cur_frame], 0, nullptr);
+#ifdef BINDLESS
+    vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe_layout, 1, 1, &bindless_set, 0, nullptr);
+#endif
+#ifdef ENABLE_PUSH_CONSTANTS
+    vkCmdPushConstants(cmd_buf, pipe_layout, VK_SHADER_STAGE_ALL_GRAPHICS, 0, sizeof(VCW_PushConstants),
+                       &push_const);
+#endif
+#ifdef GPU_DRIVEN
+    vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe_layout, OBJECT_SET, 1, &object_set, 0,
+                            nullptr);
+    if (gpu_cull) {
+#ifdef BINDLESS
+        // no per draw state in indirect draws, all instances share the texture of the first draw
+        vkCmdPushConstants(cmd_buf, pipe_layout, VK_SHADER_STAGE_ALL_GRAPHICS, offsetof(VCW_PushConstants, tex_index),
+                           sizeof(uint32_t), &draws[0].tex_index);
+#endif
+        record_indirect_draws(cmd_buf);
+        return;
+    }
+#endif
+
+    for (size_t i = first_draw; i < first_draw + draw_count; i++) {
+#ifndef INSTANCING
+        if (!scene.visible[i])
+            continue;
+#endif
+        const VCW_DrawCmd &draw = draws[i];
+        if (meshes[draw.mesh_index].index_type != index_type) {
+            index_type = meshes[draw.mesh_index].index_type;
+            vkCmdBindIndexBuffer(cmd_buf, index_buf.buf, 0, index_type);
+        }
+#ifdef QUANTIZED_VERTICES
+        if (draw.mesh_index != dequant_mesh) {
+            dequant_mesh = draw.mesh_index;
+            vkCmdPushConstants(cmd_buf, pipe_layout, VK_SHADER_STAGE_ALL_GRAPHICS, offsetof(VCW_PushConstants, dequant),
+                               sizeof(VCW_PosDequant), &meshes[dequant_mesh].dequant);
+        }
+#endif
+#ifdef BINDLESS
+        // the only per draw state, no descriptor is rebound
+        vkCmdPushConstants(cmd_buf, pipe_layout, VK_SHADER_STAGE_ALL_GRAPHICS, offsetof(VCW_PushConstants, tex_index),
+                           sizeof(uint32_t), &draw.tex_index);
+#endif
+#ifdef ENABLE_DYNAMIC_UNIFORM
+        vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe_layout, OBJECT_SET, 1,
+                                &dyn_unif_set, 1, &draw_unif_offsets[i]);
+#endif
+        vkCmdDrawIndexed(cmd_buf, draw.index_count, draw.instance_count, draw.first_index, draw.vertex_offset,
+                         draw.first_instance);
+    }
+}
+
+// only reads app state, the partitions can be recorded concurrently as each one owns its command pool
+void App::record_draws_parallel(uint32_t img_index, std::vector<VkCommandBuffer> &secondaries) {
+    VCW_FrameCmdPools &frame_pools = frame_cmd_pools[cur_frame];
+    uint32_t part_count = static_cast<uint32_t>(frame_pools.part_cmd_bufs.size());
+    size_t draws_per_part = (draws.size() + part_count - 1) / part_count;
+
+    thread_pool.parallel_for(part_count, [&](uint32_t part) {
+        size_t first_draw = std::min(draws.size(), part * draws_per_part);
+        size_t draw_count = std::min(draws_per_part, draws.size() - first_draw);
+
+        VkCommandBuffer part_cmd_buf = frame_pools.part_cmd_bufs[part];
+        begin_secondary_cmd_buf(part_cmd_buf, img_index);
+        record_draws(part_cmd_buf, first_draw, draw_count);
+
+        if (vkEndCommandBuffer(part_cmd_buf) != VK_SUCCESS)
+            throw std::runtime_error("failed to record secondary command buffer.");
+    });
+
+    secondaries.insert(secondaries.end(), frame_pools.part_cmd_bufs.begin(), frame_pools.part_cmd_bufs.end());
 }
 
 void App::record_cmd_buf(VkCommandBuffer cmd_buf, uint32_t img_index) {
@@ -402,81 +954,113 @@ void App::record_cmd_buf(VkCommandBuffer cmd_buf, uint32_t img_index) {
     rendp_begin_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
     rendp_begin_info.pClearValues = clear_values.data();
 
-    vkCmdResetQueryPool(cmd_buf, query_pool, img_index * 3, 3);
+    // timestamps belong to the frame slot, they are read back once the slot's timeline value is reached
+    uint32_t query_base = cur_frame * frame_query_count;
+    vkCmdResetQueryPool(cmd_buf, query_pool, query_base, frame_query_count);
 
-    vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query_pool, img_index * frame_query_count);
-    vkCmdBeginRenderPass(cmd_buf, &rendp_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query_pool, query_base);
 
-    vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe);
-
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float) render_extent.width;
-    viewport.height = (float) render_extent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(cmd_buf, 0, 1, &viewport);
+    // long draw lists are split over all threads, each partition records into its own secondary
+    bool parallel = draws.size() >= PARALLEL_RECORD_MIN_DRAWS;
+#ifdef GPU_DRIVEN
+    // culling is part of the gpu frame time, the draws are a handful of indirect calls
+    if (gpu_cull) {
+        record_cull(cmd_buf);
+        parallel = false;
+    }
+#endif
+    vkCmdBeginRenderPass(cmd_buf, &rendp_begin_info,
+                         parallel ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
 
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = render_extent;
-    vkCmdSetScissor(cmd_buf, 0, 1, &scissor);
+    if (parallel) {
+        std::vector<VkCommandBuffer> secondaries;
+        record_draws_parallel(img_index, secondaries);
 
-    VkBuffer vert_bufs[] = {vert_buf.buf};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(cmd_buf, 0, 1, vert_bufs, offsets);
+#ifdef IMPL_IMGUI
+        if (!headless) {
+            // a subpass recorded with secondaries can not take inline commands
+            VkCommandBuffer ui_cmd_buf = frame_cmd_pools[cur_frame].ui_cmd_buf;
+            begin_secondary_cmd_buf(ui_cmd_buf, img_index);
 
-    vkCmdBindIndexBuffer(cmd_buf, index_buf.buf, 0, VK_INDEX_TYPE_UINT16);
+            ImGui::Render();
+            ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), ui_cmd_buf);
 
-    vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe_layout, 0, 1,
-                            &desc_sets[cur_frame], 0, nullptr);
-#ifdef ENABLE_PUSH_CONSTANTS
-    vkCmdPushConstants(cmd_buf, pipe_layout, VK_SHADER_STAGE_ALL_GRAPHICS, 0, sizeof(VCW_PushConstants),
-                       &push_const);
+            if (vkEndCommandBuffer(ui_cmd_buf) != VK_SUCCESS)
+                throw std::runtime_error("failed to record secondary command buffer.");
+            secondaries.push_back(ui_cmd_buf);
+        }
 #endif
 
-    vkCmdDrawIndexed(cmd_buf, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+        vkCmdExecuteCommands(cmd_buf, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+    } else {
+        record_draws(cmd_buf, 0, draws.size());
 
 #ifdef IMPL_IMGUI
-    ImGui::Render();
-    ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmd_buf);
+        if (!headless) {
+            ImGui::Render();
+            ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmd_buf);
+        }
 #endif
+    }
 
     vkCmdEndRenderPass(cmd_buf);
 
-    vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, query_pool, img_index * frame_query_count + 1);
+    vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, query_pool, query_base + 1);
+
+    if (headless) {
+        // set by renderpass
+        render_targets[img_index].cur_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+        if (!frame_out_dir.empty()) {
+            cp_img_to_buf(cmd_buf, render_targets[img_index], readback_buf, img_index * readback_frame_size);
+
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.buffer = readback_buf.buf;
+            barrier.offset = img_index * readback_frame_size;
+            barrier.size = readback_frame_size;
+
+            vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr,
+                                 1, &barrier, 0, nullptr);
+        }
+    }
 
 #ifdef INTERMEDIATE_RENDER_TARGET
-    // set by renderpass
-    render_targets[img_index].cur_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    if (!headless) {
+        // set by renderpass
+        render_targets[img_index].cur_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 
-    swap_imgs[img_index].cur_layout = VK_IMAGE_LAYOUT_UNDEFINED;
-    transition_img_layout(cmd_buf, &swap_imgs[img_index], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                          VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+        swap_imgs[img_index].cur_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        transition_img_layout(cmd_buf, &swap_imgs[img_index], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                              VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 
 #ifdef TESTING_COPY_INSTEAD_BLIT_IMG
-    copy_img(cmd_buf, render_targets[img_index], swap_imgs[img_index]);
+        copy_img(cmd_buf, render_targets[img_index], swap_imgs[img_index]);
 #else
-    VkExtent3D src_extent = {render_extent.width, render_extent.height, 0};
-    blit_img(cmd_buf, render_targets[img_index], src_extent, swap_imgs[img_index], swap_imgs[img_index].extent,
-             VK_FILTER_LINEAR);
+        VkExtent3D src_extent = {render_extent.width, render_extent.height, 0};
+        blit_img(cmd_buf, render_targets[img_index], src_extent, swap_imgs[img_index], swap_imgs[img_index].extent,
+                 VK_FILTER_LINEAR);
 #endif
 
-    transition_img_layout(cmd_buf, &swap_imgs[img_index], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-                          VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        transition_img_layout(cmd_buf, &swap_imgs[img_index], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                              VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+    }
 #endif
 
-    vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool, img_index * frame_query_count + 2);
+    vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool, query_base + 2);
 
     if (vkEndCommandBuffer(cmd_buf) != VK_SUCCESS)
         throw std::runtime_error("failed to record command buffer.");
 }
 
-void App::fetch_queries(uint32_t img_index) {
+void App::fetch_queries(uint32_t slot) {
     std::vector<uint64_t> buffer(frame_query_count);
 
-    VkResult result = vkGetQueryPoolResults(dev, query_pool, img_index * frame_query_count, frame_query_count,
+    VkResult result = vkGetQueryPoolResults(dev, query_pool, slot * frame_query_count, frame_query_count,
                                             sizeof(uint64_t) * frame_query_count, buffer.data(), sizeof(uint64_t),
                                             VK_QUERY_RESULT_64_BIT);
     if (result == VK_NOT_READY) {
@@ -510,10 +1094,85 @@ void App::render_loop() {
         ImGui::Text(buffer);
         snprintf(buffer, sizeof(buffer), "blit img time: %fms", readable_stats.blit_img_time);
         ImGui::Text(buffer);
+        snprintf(buffer, sizeof(buffer), "record time: %fms (%zu draws, %u threads)", readable_stats.record_time,
+                 draws.size(), thread_pool.size() + 1);
+        ImGui::Text(buffer);
+        snprintf(buffer, sizeof(buffer), "visible objects: %u / %zu (%s)", scene.visible_count, scene.size(),
+                 get_cull_path_name(scene.path));
+        ImGui::Text(buffer);
+        snprintf(buffer, sizeof(buffer), "triangles: %llu (lods %s)", (unsigned long long) readable_stats.triangles,
+                 lods ? "on" : "off");
+        ImGui::Text(buffer);
         snprintf(buffer, sizeof(buffer), "camera position: %f, %f, %f", cam.pos.x, cam.pos.y, cam.pos.z);
         ImGui::Text(buffer);
         snprintf(buffer, sizeof(buffer), "timestamp period: %f", phy_dev_props.limits.timestampPeriod);
         ImGui::Text(buffer);
+        snprintf(buffer, sizeof(buffer), "upload queue family: %u (%s)", qf_upload,
+                 dedicated_upload_queue ? "dedicated" : "graphics");
+        ImGui::Text(buffer);
+
+        VCW_MemoryStats mem_stats = get_mem_stats();
+        snprintf(buffer, sizeof(buffer), "mem blocks: %u, allocs: %u", mem_stats.block_count, mem_stats.alloc_count);
+        ImGui::Text(buffer);
+        snprintf(buffer, sizeof(buffer), "mem used: %.2f / %.2f MiB", (double) mem_stats.bytes_used / 1048576.0,
+                 (double) mem_stats.bytes_reserved / 1048576.0);
+        ImGui::Text(buffer);
+        snprintf(buffer, sizeof(buffer), "mem fragmentation: %.1f%%", mem_stats.fragmentation * 100.0f);
+        ImGui::Text(buffer);
+        for (uint32_t i = 0; i < phy_dev_mem_props.memoryHeapCount; i++) {
+            snprintf(buffer, sizeof(buffer), "heap %u: %.1f / %.1f MiB%s", i,
+                     (double) get_heap_usage(i) / 1048576.0, (double) heap_budgets[i] / 1048576.0,
+                     mem_budget_supported ? "" : " (est.)");
+            ImGui::Text(buffer);
+        }
+
+        if (ImGui::CollapsingHeader("startup")) {
+            snprintf(buffer, sizeof(buffer), "total: %fms", startup_time);
+            ImGui::Text(buffer);
+            for (const auto &stage: startup_stages) {
+                snprintf(buffer, sizeof(buffer), "%s: %fms", stage.name, stage.time);
+                ImGui::Text(buffer);
+            }
+            snprintf(buffer, sizeof(buffer), "pipeline creation: %fms (%s cache)", pipe_create_time,
+                     pipe_cache_warm ? "warm" : "cold");
+            ImGui::Text(buffer);
+        }
+
+        const char *desc_update_names[] = {"writes", "template", "push"};
+        snprintf(buffer, sizeof(buffer), "desc sets: %u, frame pools: %zu, layouts: %zu (%s)",
+                 frame_desc_allocs[cur_frame].set_count, frame_desc_allocs[cur_frame].pools.size(),
+                 desc_layout_cache.size(), desc_update_names[desc_update_mode]);
+        ImGui::Text(buffer);
+#ifdef ENABLE_DYNAMIC_UNIFORM
+        snprintf(buffer, sizeof(buffer), "object data: %.1f / %.1f KiB per frame", (double) dyn_unif_head / 1024.0,
+                 (double) dyn_unif_frame_size / 1024.0);
+        ImGui::Text(buffer);
+#endif
+#ifdef GPU_DRIVEN
+        snprintf(buffer, sizeof(buffer), "gpu driven: %s", !gpu_cull ? "off (cpu draws)"
+                 : draw_indirect_count ? "culled, indirect count" : "culled, fixed indirect slots");
+        ImGui::Text(buffer);
+#endif
+#ifdef BINDLESS
+        snprintf(buffer, sizeof(buffer), "bindless: %zu / %u textures, %zu / %u buffers",
+                 bindless_tex_capacity - bindless_free_texs.size(), bindless_tex_capacity,
+                 bindless_buf_capacity - bindless_free_bufs.size(), bindless_buf_capacity);
+        ImGui::Text(buffer);
+#endif
+
+        if (!stream_texs.empty() && ImGui::CollapsingHeader("texture streaming")) {
+            snprintf(buffer, sizeof(buffer), "resident: %u / %zu (%u loading)", stream_stats.resident_count,
+                     stream_texs.size(), stream_stats.pending_count);
+            ImGui::Text(buffer);
+            snprintf(buffer, sizeof(buffer), "memory: %.1f / %.1f MiB", (double) stream_stats.resident_bytes / 1048576.0,
+                     (double) tex_budget / 1048576.0);
+            ImGui::Text(buffer);
+            snprintf(buffer, sizeof(buffer), "wanted: %.1f MiB", (double) stream_stats.wanted_bytes / 1048576.0);
+            ImGui::Text(buffer);
+            snprintf(buffer, sizeof(buffer), "promotions: %u, evictions: %u", stream_stats.promotions,
+                     stream_stats.evictions);
+            ImGui::Text(buffer);
+        }
 
         ImGui::End();
 #endif
@@ -549,6 +1208,10 @@ void App::render_loop() {
             readable_stats.frame_time = stats.frame_time;
             readable_stats.gpu_frame_time = stats.gpu_frame_time;
             readable_stats.blit_img_time = stats.blit_img_time;
+            readable_stats.record_time = stats.record_time;
+            readable_stats.triangles = stats.triangles;
+
+            update_mem_budget();
 
             last_frame_checkpoint = std::chrono::high_resolution_clock::now();
         }
@@ -558,41 +1221,71 @@ void App::render_loop() {
 }
 
 void App::clean_up() {
+    clean_up_deletions();
     clean_up_swap();
 
-    ImGui_ImplVulkan_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+    if (headless) {
+        clean_up_buf(readback_buf);
+    } else {
+        ImGui_ImplVulkan_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+    }
 
     clean_up_pipe();
+    clean_up_mip_pipe();
+    save_pipe_cache();
+    clean_up_pipe_cache();
     clean_up_desc();
+#ifdef BINDLESS
+    clean_up_bindless();
+#endif
+#ifdef ENABLE_DYNAMIC_UNIFORM
+    clean_up_dyn_unif_ring();
+#endif
+#ifdef GPU_DRIVEN
+    clean_up_gpu_driven();
+#endif
+#ifdef INSTANCING
+    clean_up_buf(instance_vert_buf);
+#endif
 
 #ifdef ENABLE_UNIFORM
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (size_t i = 0; i < frames_in_flight; i++)
         clean_up_buf(unif_bufs[i]);
 #endif
 #ifdef BIND_SAMPLE_TEXTURE
     clean_up_img(tex_img);
 #endif
+    clean_up_tex_streaming();
 
-    clean_up_buf(vert_buf);
-    clean_up_buf(index_buf);
+    clean_up_geometry_store();
 
     vkDestroyQueryPool(dev, query_pool, nullptr);
 
-    clean_up_sync();
+    clean_up_staging_ring();
 
+    clean_up_sync();
+    clean_up_cmd_bufs();
+    vkDestroyCommandPool(dev, upload_cmd_pool, nullptr);
     vkDestroyCommandPool(dev, cmd_pool, nullptr);
+
+    clean_up_mem();
     vkDestroyDevice(dev, nullptr);
 
 #ifdef VALIDATION
     destroy_debug_callback(inst, debug_msg, nullptr);
 #endif
 
-    vkDestroySurfaceKHR(inst, surf, nullptr);
+    if (!headless)
+        vkDestroySurfaceKHR(inst, surf, nullptr);
     vkDestroyInstance(inst, nullptr);
 
-    glfwDestroyWindow(window);
+    if (!headless) {
+        glfwDestroyWindow(window);
+
+        glfwTerminate();
+    }
 
-    glfwTerminate();
+    thread_pool.destroy();
 }
\ No newline at end of file
@@ -5,8 +5,15 @@
 #include "inc.h"
 #include "prop.h"
 #include "util.h"
+#include "thread_pool.h"
 
 #include "render/camera.h"
+#include "render/texture.h"
+#include "render/scene.h"
+#include "render/mesh.h"
+#include "render/vertex_layout.h"
+#include "render/lod.h"
+#include "render/meshlet.h"
 
 #ifndef VCW_APP_H
 #define VCW_APP_H
@@ -30,6 +37,8 @@ bool check_validation_support();
 struct VCW_QueueFamilyIndices {
     std::optional<uint32_t> qf_graph;
     std::optional<uint32_t> qf_pres;
+    // optional, transfer-only or async compute family for uploads
+    std::optional<uint32_t> qf_transfer;
 
     bool is_complete() {
         return qf_graph.has_value() && qf_pres.has_value();
@@ -42,35 +51,175 @@ struct VCW_SwapSupport {
     std::vector<VkPresentModeKHR> pres_modes;
 };
 
-struct Vertex {
-    glm::vec3 pos;
-    glm::vec2 uv;
+// cpu work that does not need the device, started on the workers before the instance exists
+struct VCW_StartupPrefetch {
+    std::future<std::vector<char>> vert_code;
+    std::future<std::vector<char>> frag_code;
+    std::future<VCW_ImageData> tex_data;
+    // one per mesh path, or the built-in mesh
+    std::vector<std::future<VCW_Mesh>> meshes;
+};
 
-    static VkVertexInputBindingDescription get_binding_desc();
+struct VCW_StartupStage {
+    const char *name;
+    double time;
+};
 
-    static std::array<VkVertexInputAttributeDescription, 2> get_attrib_descs();
+struct VCW_DrawCmd {
+    uint32_t index_count;
+    uint32_t instance_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+    uint32_t first_instance;
+    // slot in the bindless texture table
+    uint32_t tex_index = 0;
+    glm::mat4 model = glm::mat4(1.0f);
+    // range of the geometry store the draw reads
+    uint32_t mesh_index = 0;
+    // detail level of the mesh, fixed per draw with INSTANCING, picked every frame otherwise
+    uint32_t lod = 0;
+};
+
+// a mesh's part of the geometry store, first_index counts in indices of the mesh's index type
+struct VCW_MeshRange {
+    uint32_t first_index;
+    uint32_t index_count;
+    int32_t vertex_offset;
+    uint32_t vertex_count;
+    VkIndexType index_type;
+    // bounds after the axis flip of shader.vert
+    glm::vec4 sphere;
+    // maps quantized positions back into the mesh's space
+    VCW_PosDequant dequant;
+    // lods[0] is the range above
+    std::array<VCW_LodRange, LOD_MAX_LEVELS> lods;
+    uint32_t lod_count;
+    // clusters of the full mesh in App::gpu_meshlets
+    uint32_t first_meshlet;
+    uint32_t meshlet_count;
 };
 
 struct VCW_PushConstants {
     alignas(16) glm::mat4 view_proj;
     alignas(8) glm::vec2 res;
     alignas(4) uint32_t time;
+    // pushed per draw in bindless mode
+    alignas(4) uint32_t tex_index;
+#ifdef QUANTIZED_VERTICES
+    // pushed whenever the mesh changes
+    alignas(16) VCW_PosDequant dequant;
+#endif
 };
 
 struct VCW_Uniform {
     alignas(16) glm::mat4 data;
 };
 
+// per draw data in the dynamic uniform ring
+struct VCW_ObjectUniform {
+    alignas(16) glm::mat4 model;
+};
+
+// per instance vertex stream of the instancing path, binding 1 after the mesh's vertices
+struct VCW_InstanceData {
+    glm::mat4 model;
+    // slot in the bindless texture table
+    uint32_t material;
+
+    static VkVertexInputBindingDescription get_binding_desc();
+
+    static std::array<VkVertexInputAttributeDescription, 5> get_attrib_descs();
+};
+
+// one per draw in the gpu driven instance buffer, std430 layout of cull.comp and shader.vert
+struct VCW_GpuInstance {
+    alignas(16) glm::mat4 model;
+    // object space bounding sphere, xyz center, w radius
+    alignas(16) glm::vec4 sphere;
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+    // the mesh's clusters and the instance's first indirect command slot with MESHLETS
+    uint32_t first_meshlet;
+    uint32_t meshlet_count;
+    uint32_t first_cluster;
+};
+
+// std430 layout of cull.comp, bounds after the axis flip of shader.vert
+struct VCW_GpuMeshlet {
+    alignas(16) glm::vec4 sphere;
+    // xyz axis of the front face normals, w cutoff, above 1 if the cluster is never cone culled
+    alignas(16) glm::vec4 cone;
+    // in the geometry store's index buffer
+    uint32_t first_index;
+    uint32_t index_count;
+};
+
+struct VCW_CullPushConstants {
+    glm::vec4 planes[6];
+    uint32_t instance_count;
+    uint32_t compact;
+    // the cone test of the clusters needs the camera position
+    alignas(16) glm::vec4 cam_pos;
+};
+
+struct VCW_UniformSlice {
+    void *p_data;
+    // absolute offset in the ring buffer, passed as dynamic offset
+    uint32_t offset;
+};
+
+struct VCW_MemoryRange {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+};
+
+struct VCW_MemoryBlock {
+    VkDeviceMemory mem = VK_NULL_HANDLE;
+    VkDeviceSize size;
+    uint32_t mem_type;
+    // buffers and linear images never share a block with optimal images (bufferImageGranularity)
+    bool linear;
+    bool dedicated;
+
+    VkDeviceSize used;
+    uint32_t alloc_count;
+    // sorted by offset, neighbours are merged on free
+    std::vector<VCW_MemoryRange> free_ranges;
+
+    void *p_mapped_mem = nullptr;
+};
+
+struct VCW_Allocation {
+    uint32_t block;
+    VkDeviceMemory mem;
+    VkMemoryPropertyFlags mem_flags;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+};
+
+struct VCW_MemoryStats {
+    uint32_t block_count;
+    uint32_t alloc_count;
+    VkDeviceSize bytes_reserved;
+    VkDeviceSize bytes_used;
+    // 1 - largest free range / total free bytes
+    float fragmentation;
+};
+
 struct VCW_Buffer {
     VkDeviceSize size;
     VkBuffer buf;
-    VkDeviceMemory mem;
+    VCW_Allocation alloc;
     void *p_mapped_mem = nullptr;
+    // graphics timeline value of the last submission when the buffer was created, while no submission followed,
+    // nothing on the gpu can read or write the buffer
+    uint64_t create_timeline_value = 0;
 };
 
 struct VCW_Image {
     VkImage img;
-    VkDeviceMemory mem;
+    VCW_Allocation alloc;
 
     VkImageView view;
 
@@ -79,25 +228,214 @@ struct VCW_Image {
 
     VkExtent3D extent;
     VkFormat format;
+    // layout of every subresource, only differs per mip level while mips are generated
     VkImageLayout cur_layout;
+    uint32_t mip_levels = 1;
+    uint32_t array_layers = 1;
+    // usage of views in the image's own format, 0 for all of the image's usage
+    VkImageUsageFlags view_usage = 0;
+};
+
+struct VCW_StagingRegion {
+    VCW_Buffer buf;
+    VkDeviceSize offset;
+    void *p_mapped_mem;
+};
+
+struct VCW_UploadBatch {
+    // copies, recorded for the upload queue
+    VkCommandBuffer cmd_buf;
+    // ownership acquire on the graphics queue, only used with a dedicated upload queue
+    VkCommandBuffer gfx_cmd_buf;
+    uint64_t token;
+    // graphics timeline value signaled once the batch is visible to rendering
+    uint64_t timeline_value;
+    // ring position that becomes free once the batch retired
+    uint64_t ring_end;
+    // staging buffers for uploads that do not fit into the ring
+    std::vector<VCW_Buffer> overflow_bufs;
+    // per level views and descriptors of compute mip generation
+    std::vector<VkImageView> tmp_views;
+    std::vector<VkDescriptorPool> tmp_desc_pools;
+};
+
+// identical bindings (and flags) map to one cached layout
+struct VCW_DescLayoutKey {
+    std::vector<VkDescriptorSetLayoutBinding> bindings;
+    std::vector<VkDescriptorBindingFlags> binding_flags;
+    VkDescriptorSetLayoutCreateFlags flags;
+
+    bool operator==(const VCW_DescLayoutKey &other) const;
+};
+
+struct VCW_DescLayoutKeyHash {
+    size_t operator()(const VCW_DescLayoutKey &key) const;
+};
+
+enum VCW_DescUpdateMode {
+    // one VkWriteDescriptorSet per binding, batched into one vkUpdateDescriptorSets
+    DESC_UPDATE_WRITES,
+    // the whole set from one packed array of infos
+    DESC_UPDATE_TEMPLATE,
+    // no set at all, the infos are pushed into the command buffer
+    DESC_UPDATE_PUSH
+};
+
+// one entry per descriptor in binding order, the packed data read by an update template
+union VCW_DescInfo {
+    VkDescriptorBufferInfo buf;
+    VkDescriptorImageInfo img;
+};
+
+// descriptor pools of one frame slot, all reset together once the slot is free again
+struct VCW_DescAllocator {
+    std::vector<VkDescriptorPool> pools;
+    // pools before this one are full until the next reset
+    uint32_t cur_pool;
+    uint32_t set_count;
+};
+
+struct VCW_DeferredDeletion {
+    // graphics timeline value after which no submission references the resources
+    uint64_t timeline_value;
+    std::function<void()> destroy;
+};
+
+struct VCW_FrameCmdPools {
+    // primary and imgui secondary, the whole pool is reset every frame
+    VkCommandPool pool;
+    VkCommandBuffer ui_cmd_buf;
+    // one pool per draw list partition, a pool must never be used by two threads at once
+    std::vector<VkCommandPool> part_pools;
+    std::vector<VkCommandBuffer> part_cmd_bufs;
+};
+
+enum VCW_StreamState {
+    STREAM_LOADING,
+    STREAM_RESIDENT,
+    STREAM_FAILED
+};
+
+// levels [resident_base, mip_count) live in img, finer levels are promoted as the camera approaches
+struct VCW_StreamTexture {
+    std::string path;
+    VCW_StreamState state = STREAM_LOADING;
+    std::future<VCW_ImageData> pending;
+    // the full chain stays on the cpu, an image is rebuilt from it whenever its residency changes
+    VCW_ImageData data;
+
+    // placement of the objects using the texture, drives the wanted level
+    glm::vec3 pos;
+    float radius;
+
+    VCW_Image img;
+    // bumped whenever the image is rebuilt
+    uint32_t img_version;
+    // one stable slot per frame in flight, a frame's slot is rewritten in place once the frame's last submission
+    // is done, the other frames keep sampling the image they were recorded with
+    std::vector<uint32_t> bindless_slots;
+    std::vector<uint32_t> slot_versions;
+    // scene object drawn with the texture
+    uint32_t object = UINT32_MAX;
+    uint32_t resident_base;
+    uint32_t desired_base;
+    // coarsest base, the tail up to STREAM_TAIL_SIZE is never evicted
+    uint32_t tail_base;
+    VkDeviceSize resident_bytes;
+    float distance;
+    // last frame the texture was drawn (all resident levels were wanted without STREAM_DRAWS)
+    uint32_t last_use;
+};
+
+struct VCW_StreamStats {
+    uint32_t resident_count;
+    uint32_t pending_count;
+    VkDeviceSize resident_bytes;
+    // bytes if every texture had its wanted levels resident
+    VkDeviceSize wanted_bytes;
+    uint32_t promotions;
+    uint32_t evictions;
 };
 
 struct VCW_RenderStats {
     double frame_time;
     double gpu_frame_time;
     double blit_img_time;
+    double record_time;
     uint32_t frame_count;
+    // triangles of the draws submitted in the last frame
+    uint64_t triangles;
 };
 
 class App {
 public:
     void run() {
-        init_window();
+        start_prefetch();
+        if (!headless)
+            init_window();
+        end_startup_stage("window");
         init_app();
-        render_loop();
+        if (headless && stress_max > 0)
+            stress_loop();
+        else if (headless && lod_bench)
+            lod_bench_loop();
+        else if (headless && mip_bench)
+            mip_bench_loop();
+        else if (headless)
+            headless_loop();
+        else
+            render_loop();
         clean_up();
     }
 
+    // frames the cpu may record ahead of the gpu
+    uint32_t frames_in_flight = DEFAULT_FRAMES_IN_FLIGHT;
+    // full mip chains for textures, off for sampling bandwidth comparisons
+    bool tex_mips = true;
+    // .ktx2 and .dds keep their block compression and stored mip chain, anything else goes through stb_image
+    std::string tex_path = TEXTURE_PATH;
+    // .vcwm files are mapped, .obj / .gltf / .glb are imported and optimized at startup, the built-in mesh if empty,
+    // objects take the meshes in turn
+    std::vector<std::string> mesh_paths;
+    // every image in this directory is streamed, see add_stream_dir
+    std::string stream_dir;
+    VkDeviceSize tex_budget = TEXTURE_BUDGET;
+    VCW_DescUpdateMode desc_update_mode = DEFAULT_DESC_UPDATE_MODE;
+    // descriptor update paths are timed at startup if not 0
+    uint32_t desc_bench_iterations = 0;
+    uint32_t object_count = OBJECT_COUNT;
+    // with GPU_DRIVEN, false records one draw per object on the cpu instead (the baseline of the culling pass)
+    bool gpu_cull = true;
+    // objects outside the camera frustum are skipped on the cpu (the gpu driven path culls on the gpu)
+    bool cpu_cull = true;
+    // times the scene culling paths at startup
+    bool cull_bench = false;
+    // headless runs step the object count up to this value if not 0, see stress_loop
+    uint32_t stress_max = 0;
+    // objects pick a detail level by their projected error, false draws every mesh in full
+    bool lods = true;
+    float lod_pixel_error = LOD_PIXEL_ERROR;
+    // headless runs render the scene from behind without and with lods, see lod_bench_loop
+    bool lod_bench = false;
+    // prints the cluster culling rates of the startup meshes, see bench_meshlets
+    bool meshlet_bench = false;
+    // headless runs time mip generation and render with and without the texture's mips, see mip_bench_loop
+    bool mip_bench = false;
+
+    //
+    // headless mode renders offscreen without glfw or a surface
+    //
+    bool headless = false;
+    uint32_t headless_frame_count = HEADLESS_FRAME_COUNT;
+    // frames are only read back if an output directory is set
+    std::string frame_out_dir;
+    bool frame_out_raw = false;
+
+    VCW_Buffer readback_buf;
+    VkDeviceSize readback_frame_size;
+    // frame written into each readback slot, UINT32_MAX if the slot is empty
+    std::vector<uint32_t> readback_frames;
+
     GLFWwindow *window;
     bool resized = false;
     glm::vec2 mouse_pos;
@@ -113,12 +451,38 @@ public:
     VkPhysicalDevice phy_dev = VK_NULL_HANDLE;
     VkPhysicalDeviceMemoryProperties phy_dev_mem_props;
     VkPhysicalDeviceProperties phy_dev_props;
+    bool storage_write_without_format = false;
+    // optional, gpu driven rendering falls back to one indirect draw per call / fixed draw slots without them
+    bool multi_draw_indirect = false;
+    bool draw_indirect_count = false;
+    // integrated / software device, device local memory is usually host visible as well
+    bool uma = false;
+    // preferred flags for static device local data, lets uma devices skip staging
+    VkMemoryPropertyFlags static_pref_mem_props = 0;
+    // (type filter, required flags, preferred flags) -> memory type
+    std::unordered_map<uint64_t, uint32_t> mem_type_lut;
+
+    bool mem_budget_supported = false;
+    bool push_desc_supported = false;
+    PFN_vkCmdPushDescriptorSetWithTemplateKHR p_cmd_push_desc_template = nullptr;
+    std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heap_budgets{};
+    std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heap_usages{};
+    // bytes in blocks of this allocator, and the same value when the budget was last queried
+    std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heap_alloc_bytes{};
+    std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heap_alloc_bytes_at_query{};
 
     std::vector<VkQueueFamilyProperties> qf_props;
     VCW_QueueFamilyIndices qf_indices;
+    std::vector<const char *> enabled_dev_exts;
     VkDevice dev;
     VkQueue q_graph;
     VkQueue q_pres;
+    // falls back to the graphics family and queue if there is no dedicated one
+    uint32_t qf_upload;
+    VkQueue q_upload;
+    bool dedicated_upload_queue = false;
+    // false keeps the uploads on the graphics queue even if the device has a transfer family (--no-transfer-queue)
+    bool transfer_queue = true;
 
     VkSwapchainKHR swap;
     std::vector<VCW_Image> swap_imgs;
@@ -129,24 +493,114 @@ public:
     VkRenderPass rendp;
     VkPipelineLayout pipe_layout;
     VkPipeline pipe;
+    // compute mip generation, created on first use
+    VkDescriptorSetLayout mip_desc_set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout mip_pipe_layout = VK_NULL_HANDLE;
+    VkPipeline mip_pipe = VK_NULL_HANDLE;
+    VkPipelineCache pipe_cache;
+    // the cache was loaded from disk and matched the device
+    bool pipe_cache_warm = false;
+    double pipe_create_time = 0.0;
     std::vector<VkFramebuffer> frame_bufs;
     std::vector<VCW_Image> render_targets;
 
-    std::vector<VkDescriptorSetLayout> desc_set_layouts;
+    std::unordered_map<VCW_DescLayoutKey, VkDescriptorSetLayout, VCW_DescLayoutKeyHash> desc_layout_cache;
+    // layout of the per frame sets (uniform buffer, sample texture)
+    VkDescriptorSetLayout frame_desc_set_layout;
+    std::vector<VkDescriptorSetLayoutBinding> frame_desc_bindings;
+    std::vector<VCW_DescAllocator> frame_desc_allocs;
+    // reallocated from the frame's pools every frame, unused with push descriptors
+    std::vector<VkDescriptorSet> desc_sets;
+    // template and packed infos of the per frame set, if not written with DESC_UPDATE_WRITES
+    VkDescriptorUpdateTemplate frame_desc_template = VK_NULL_HANDLE;
+    std::vector<std::vector<VCW_DescInfo>> frame_desc_data;
+    // long lived pool for imgui, which frees its sets individually
     std::vector<VkDescriptorPoolSize> desc_pool_sizes;
     VkDescriptorPool desc_pool;
-    std::vector<VkDescriptorSet> desc_sets;
+
+    // queued writes, infos live in deques so the write pointers stay valid
+    std::vector<VkWriteDescriptorSet> desc_writes;
+    std::deque<VkDescriptorBufferInfo> desc_buf_infos;
+    std::deque<VkDescriptorImageInfo> desc_img_infos;
+
+    // bindless table, slots are handed out from the free lists
+    VkDescriptorSetLayout bindless_set_layout;
+    VkDescriptorPool bindless_pool;
+    VkDescriptorSet bindless_set;
+    uint32_t bindless_tex_capacity = 0;
+    uint32_t bindless_buf_capacity = 0;
+    std::vector<uint32_t> bindless_free_texs;
+    std::vector<uint32_t> bindless_free_bufs;
+    uint32_t tex_bindless_index = 0;
 
     VkCommandPool cmd_pool;
+    VkCommandPool upload_cmd_pool;
     std::vector<VkCommandBuffer> cmd_bufs;
+    std::vector<VCW_FrameCmdPools> frame_cmd_pools;
+
+    VCW_ThreadPool thread_pool;
+
+    VCW_StartupPrefetch prefetch;
+    std::chrono::high_resolution_clock::time_point startup_start_time;
+    std::chrono::high_resolution_clock::time_point startup_checkpoint;
+    std::vector<VCW_StartupStage> startup_stages;
+    double startup_time = 0.0;
+
+    std::vector<VCW_MemoryBlock> mem_blocks;
+
+    VCW_Buffer staging_ring;
+    // virtual positions, the physical ring offset is pos % staging_ring.size
+    uint64_t staging_head = 0;
+    uint64_t staging_tail = 0;
+    bool upload_recording = false;
+    VCW_UploadBatch upload_batch;
+    std::deque<VCW_UploadBatch> upload_batches;
+    std::vector<VCW_UploadBatch> free_upload_batches;
+    uint64_t upload_token = 0;
+    uint64_t upload_completed = 0;
 
     VCW_Image depth_img;
     VCW_Image tex_img;
 
-    std::vector<Vertex> vertices;
+    // geometry store, every mesh is a range of these buffers,
+    // vert_buf holds VCW_Layout's first stream and attrib_buf its second one if the layout is split
     VCW_Buffer vert_buf;
-    std::vector<uint16_t> indices;
+    VCW_Buffer attrib_buf;
     VCW_Buffer index_buf;
+    // next free vertex and index byte
+    VkDeviceSize geo_vert_head = 0;
+    VkDeviceSize geo_index_head = 0;
+    std::vector<VCW_MeshRange> meshes;
+    // clusters of all meshes, see VCW_MeshRange::first_meshlet
+    std::vector<VCW_GpuMeshlet> gpu_meshlets;
+    std::vector<VCW_DrawCmd> draws;
+    // dynamic offsets of the draws' object data this frame
+    std::vector<uint32_t> draw_unif_offsets;
+    // one bounding sphere per object, draws (or instances with INSTANCING) follow the scene's order
+    VCW_Scene scene;
+
+    // instancing, every frame region of the vertex buffer holds instance_capacity instances
+    std::vector<VCW_InstanceData> instances;
+    // instances of mesh m are instances[instance_offsets[m]] up to instances[instance_offsets[m + 1]],
+    // each of its draws packs those at the draw's detail level
+    std::vector<uint32_t> instance_offsets;
+    VCW_Buffer instance_vert_buf;
+    uint32_t instance_capacity = 0;
+
+    // gpu driven rendering, one instance per draw and a region of indirect commands per frame
+    VCW_Buffer instance_buf;
+    VCW_Buffer indirect_buf;
+    VkDeviceSize indirect_frame_size = 0;
+    // command slots per frame, one per instance or with MESHLETS one per cluster of every instance
+    uint32_t indirect_cmd_count = 0;
+    VCW_Buffer meshlet_buf;
+    VkDescriptorSetLayout object_set_layout;
+    VkDescriptorSetLayout cull_set_layout;
+    VkDescriptorPool gpu_driven_pool;
+    VkDescriptorSet object_set;
+    VkDescriptorSet cull_set;
+    VkPipelineLayout cull_pipe_layout;
+    VkPipeline cull_pipe;
 
     VkQueryPool query_pool;
     uint32_t frame_query_count;
@@ -156,16 +610,38 @@ public:
     VCW_Uniform ubo;
     std::vector<VCW_Buffer> unif_bufs;
 
+    // linear allocator per frame region, reset when the frame slot comes around again
+    VCW_Buffer dyn_unif_buf;
+    VkDeviceSize dyn_unif_align = 0;
+    VkDeviceSize dyn_unif_frame_size = 0;
+    uint32_t dyn_unif_frame = 0;
+    VkDeviceSize dyn_unif_head = 0;
+    VkDescriptorSetLayout dyn_unif_set_layout;
+    VkDescriptorPool dyn_unif_pool;
+    VkDescriptorSet dyn_unif_set;
+
     std::vector<VkSemaphore> img_avl_semps;
     std::vector<VkSemaphore> rend_fin_semps;
-    std::vector<VkFence> fens;
+    // every submission to the graphics queue signals the next value,
+    // a frame slot can be reused once the value of its last submission is reached
+    VkSemaphore gfx_timeline;
+    uint64_t gfx_timeline_value = 0;
+    std::vector<uint64_t> frame_timeline_values;
+    // signaled by the dedicated upload queue, waited on by the graphics acquire
+    VkSemaphore upload_timeline;
+    uint64_t upload_timeline_value = 0;
+    // ordered by timeline value
+    std::deque<VCW_DeferredDeletion> deletion_queue;
 
     uint32_t cur_frame = 0;
-    VCW_RenderStats stats;
-    VCW_RenderStats readable_stats;
+    VCW_RenderStats stats{};
+    VCW_RenderStats readable_stats{};
 
     VCW_Camera cam;
 
+    std::vector<VCW_StreamTexture> stream_texs;
+    VCW_StreamStats stream_stats{};
+
     //
     //
     //
@@ -191,7 +667,7 @@ public:
     //
     // vulkan / imgui instance
     //
-    static std::vector<const char *> get_required_exts();
+    std::vector<const char *> get_required_exts();
 
     void create_inst();
 
@@ -216,6 +692,8 @@ public:
 
     static bool check_phy_dev_ext_support(VkPhysicalDevice loc_phy_dev);
 
+    static bool check_dev_ext_support(VkPhysicalDevice loc_phy_dev, const char *ext);
+
     VCW_SwapSupport query_swap_support(VkPhysicalDevice loc_phy_dev);
 
     bool is_phy_dev_suitable(VkPhysicalDevice loc_phy_dev);
@@ -236,18 +714,56 @@ public:
 
     VkExtent2D choose_extent(const VkSurfaceCapabilitiesKHR &caps);
 
-    void create_swap();
+    void create_swap(VkSwapchainKHR old_swap = VK_NULL_HANDLE);
 
     void recreate_swap();
 
+    void retire_swap();
+
     void clean_up_swap();
 
+    //
+    // device memory
+    //
+    static std::optional<int> score_mem_type(VkMemoryPropertyFlags flags, VkMemoryPropertyFlags required,
+                                             VkMemoryPropertyFlags preferred);
+
+    void build_mem_type_lut();
+
+    int resolve_mem_type(uint32_t type_filter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred);
+
+    void update_mem_budget();
+
+    VkDeviceSize get_heap_usage(uint32_t heap);
+
+    bool heap_within_budget(uint32_t mem_type, VkDeviceSize size);
+
+    VkDeviceSize get_mem_block_size(uint32_t mem_type);
+
+    uint32_t create_mem_block(uint32_t mem_type, VkDeviceSize size, bool linear, bool dedicated);
+
+    static bool suballoc_mem_block(VCW_MemoryBlock *p_block, VkDeviceSize size, VkDeviceSize alignment,
+                                   VkDeviceSize *p_offset);
+
+    VCW_Allocation alloc_mem(VkMemoryRequirements mem_reqs, VkMemoryPropertyFlags mem_props,
+                             VkMemoryPropertyFlags pref_mem_props, bool linear);
+
+    void *map_mem(VCW_Allocation alloc);
+
+    void free_mem(VCW_Allocation alloc);
+
+    VCW_MemoryStats get_mem_stats();
+
+    void clean_up_mem();
+
     //
     // buffers
     //
-    uint32_t find_mem_type(uint32_t type_filter, VkMemoryPropertyFlags mem_flags);
+    uint32_t find_mem_type(uint32_t type_filter, VkMemoryPropertyFlags mem_flags,
+                           VkMemoryPropertyFlags pref_mem_flags = 0);
 
-    VCW_Buffer create_buf(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags mem_props);
+    VCW_Buffer create_buf(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags mem_props,
+                          VkMemoryPropertyFlags pref_mem_props = 0);
 
     void map_buf(VCW_Buffer *p_buf);
 
@@ -270,7 +786,8 @@ public:
     bool has_stencil_component(VkFormat format);
 
     VCW_Image create_img(VkExtent2D extent, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-                         VkMemoryPropertyFlags mem_props);
+                         VkMemoryPropertyFlags mem_props, uint32_t mip_levels = 1, uint32_t array_layers = 1,
+                         VkImageCreateFlags flags = 0);
 
     void create_img_view(VCW_Image *p_img, VkImageAspectFlags aspect_flags);
 
@@ -278,10 +795,20 @@ public:
 
     static VkAccessFlags get_access_mask(VkImageLayout layout);
 
+    static VkImageSubresourceRange get_subresource_range(const VCW_Image &img);
+
     static void transition_img_layout(VkCommandBuffer cmd_buf, VCW_Image *p_img, VkImageLayout layout,
                                       VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage);
 
-    static void cp_buf_to_img(VkCommandBuffer cmd_buf, VCW_Buffer buf, VCW_Image img, VkExtent2D extent);
+    static void transition_img_subresource(VkCommandBuffer cmd_buf, VCW_Image *p_img,
+                                           const VkImageSubresourceRange &range, VkImageLayout old_layout,
+                                           VkImageLayout new_layout, VkPipelineStageFlags src_stage,
+                                           VkPipelineStageFlags dst_stage);
+
+    static void cp_img_to_buf(VkCommandBuffer cmd_buf, VCW_Image img, VCW_Buffer buf, VkDeviceSize buf_offset);
+
+    static void cp_buf_to_img(VkCommandBuffer cmd_buf, VCW_Buffer buf, VCW_Image img, VkExtent2D extent,
+                              VkDeviceSize buf_offset = 0, uint32_t mip_level = 0);
 
     static void
     blit_img(VkCommandBuffer cmd_buf, VCW_Image src, VkExtent3D src_extent, VCW_Image dst, VkExtent3D dst_extent,
@@ -291,23 +818,167 @@ public:
 
     static void copy_img(VkCommandBuffer cmd_buf, VCW_Image src, VCW_Image dst);
 
+    static uint32_t get_mip_count(VkExtent2D extent);
+
+    bool supports_mip_blit(VkFormat format);
+
+    bool supports_mip_compute(VkFormat format);
+
+    VkImageUsageFlags get_mip_gen_usage(VkFormat format);
+
+    VkImageCreateFlags get_mip_gen_flags(VkFormat format);
+
+    void generate_mips(VkCommandBuffer cmd_buf, VCW_Image *p_img);
+
+    void generate_mips_blit(VkCommandBuffer cmd_buf, VCW_Image *p_img);
+
+    void generate_mips_compute(VkCommandBuffer cmd_buf, VCW_Image *p_img);
+
+    void bench_mip_generation();
+
+    void create_mip_pipe();
+
+    void clean_up_mip_pipe();
+
     void clean_up_img(VCW_Image img);
 
+    //
+    // staging uploads
+    //
+    void create_staging_ring();
+
+    void begin_upload_batch();
+
+    VCW_StagingRegion reserve_staging(VkDeviceSize size, VkDeviceSize alignment);
+
+    void upload_to_buf(VCW_Buffer dst_buf, const void *p_data, VkDeviceSize size, VkDeviceSize dst_offset = 0);
+
+    void upload_to_img(VCW_Image *p_img, const void *p_data, VkDeviceSize size, uint32_t data_levels = 1);
+
+    void transfer_buf_ownership(VCW_Buffer buf, VkDeviceSize offset, VkDeviceSize size);
+
+    void transfer_img_ownership(VCW_Image *p_img, VkImageLayout layout, VkPipelineStageFlags dst_stage);
+
+    uint64_t flush_uploads();
+
+    void retire_upload_batch();
+
+    void retire_uploads();
+
+    void wait_uploads(uint64_t token);
+
+    void clean_up_staging_ring();
+
+    //
+    // texture streaming
+    //
+    uint32_t add_stream_tex(const std::string &path, glm::vec3 pos, float radius);
+
+    void add_stream_dir(const std::string &dir);
+
+    VCW_ImageData load_stream_data(const std::string &path);
+
+    uint32_t get_desired_base(const VCW_StreamTexture &tex);
+
+    void set_resident_base(VCW_StreamTexture *p_tex, uint32_t base);
+
+    bool evict_stream_level();
+
+    void bind_stream_texs(uint32_t frame);
+
+    void update_tex_streaming();
+
+    void clean_up_tex_streaming();
+
     //
     // descriptor pool
     //
-    void add_desc_set_layout(uint32_t binding_count, VkDescriptorSetLayoutBinding *p_bindings);
+    VkDescriptorSetLayout get_desc_set_layout(const std::vector<VkDescriptorSetLayoutBinding> &bindings,
+                                              const std::vector<VkDescriptorBindingFlags> &binding_flags = {},
+                                              VkDescriptorSetLayoutCreateFlags flags = 0);
 
     void add_pool_size(uint32_t desc_count, VkDescriptorType desc_type);
 
     void create_desc_pool(uint32_t max_sets);
 
-    void write_buf_desc_binding(VCW_Buffer buf, uint32_t dst_set, uint32_t dst_binding, VkDescriptorType desc_type);
+    VkDescriptorPool create_frame_desc_pool(uint32_t max_sets);
+
+    void create_frame_desc_allocs();
+
+    VkDescriptorSet alloc_frame_desc_set(uint32_t frame, VkDescriptorSetLayout layout);
+
+    void reset_frame_desc_pools(uint32_t frame);
+
+    void write_buf_desc_binding(VCW_Buffer buf, VkDescriptorSet dst_set, uint32_t dst_binding,
+                                VkDescriptorType desc_type, uint32_t dst_element = 0);
+
+    void write_buf_desc_binding(VkDescriptorBufferInfo buf_info, VkDescriptorSet dst_set, uint32_t dst_binding,
+                                VkDescriptorType desc_type, uint32_t dst_element = 0);
+
+    void write_img_desc_binding(VCW_Image img, VkDescriptorSet dst_set, uint32_t dst_binding,
+                                VkDescriptorType desc_type);
 
-    void write_img_desc_binding(VCW_Image img, uint32_t dst_set, uint32_t dst_binding, VkDescriptorType desc_type);
+    void write_img_desc_binding(VkDescriptorImageInfo img_info, VkDescriptorSet dst_set, uint32_t dst_binding,
+                                VkDescriptorType desc_type, uint32_t dst_element = 0);
+
+    void flush_desc_writes();
+
+    VkDescriptorUpdateTemplate create_desc_template(const std::vector<VkDescriptorSetLayoutBinding> &bindings,
+                                                    VkDescriptorSetLayout layout,
+                                                    VkPipelineLayout push_pipe_layout = VK_NULL_HANDLE,
+                                                    uint32_t push_set = 0);
+
+    void create_frame_desc_template();
+
+    void bench_desc_updates(uint32_t iterations);
 
     void clean_up_desc();
 
+    //
+    // bindless
+    //
+    void create_bindless();
+
+    uint32_t add_bindless_tex(const VCW_Image &img);
+
+    uint32_t reserve_bindless_tex();
+
+    void write_bindless_tex(uint32_t index, const VCW_Image &img);
+
+    void remove_bindless_tex(uint32_t index);
+
+    uint32_t add_bindless_buf(const VCW_Buffer &buf);
+
+    void remove_bindless_buf(uint32_t index);
+
+    void clean_up_bindless();
+
+    //
+    // gpu driven rendering
+    //
+    void create_cull_pipe();
+
+    void create_instance_bufs();
+
+    void record_cull(VkCommandBuffer cmd_buf);
+
+    void record_indirect_draws(VkCommandBuffer cmd_buf);
+
+    void clean_up_gpu_driven();
+
+    //
+    // dynamic uniform ring
+    //
+    void create_dyn_unif_ring();
+
+    void create_dyn_unif_buf(uint32_t count);
+
+    void reset_dyn_unif_ring(uint32_t frame);
+
+    VCW_UniformSlice alloc_dyn_unif(VkDeviceSize size);
+
+    void clean_up_dyn_unif_ring();
+
     //
     // pipeline prerequisites
     //
@@ -319,8 +990,14 @@ public:
 
     void create_frame_bufs(std::vector<VCW_Image> img_targets);
 
+    void create_pipe_cache();
+
+    void save_pipe_cache();
+
     void clean_up_pipe();
 
+    void clean_up_pipe_cache();
+
     //
     // render prerequisites
     //
@@ -332,24 +1009,82 @@ public:
 
     void create_cmd_bufs();
 
+    void reset_frame_cmd_pools(uint32_t frame);
+
+    void clean_up_cmd_bufs();
+
     void create_sync();
 
     void create_query_pool(uint32_t loc_frame_query_count);
 
+    uint64_t get_gfx_timeline_completed();
+
+    void wait_gfx_timeline(uint64_t value);
+
+    void defer_deletion(std::function<void()> destroy, uint64_t delay = 0);
+
+    void flush_deletions();
+
+    void clean_up_deletions();
+
     void render();
 
     void clean_up_sync();
 
+    //
+    // headless
+    //
+    void create_headless_targets();
+
+    void create_readback_buf();
+
+    void write_frame(uint32_t slot);
+
+    void render_headless();
+
+    void headless_loop();
+
+    void stress_loop();
+
+    void lod_bench_loop();
+
+    void mip_bench_loop();
+
     //
     //
     // personalized vulkan initialization
     //
-    void create_vert_buf(const std::vector<Vertex> &vertices_dataset);
+    void create_geometry_store(VkDeviceSize vertex_capacity, VkDeviceSize index_capacity);
+
+    uint32_t add_mesh(const VCW_Mesh &mesh);
+
+    // vertex bytes the visible objects read per frame if every vertex is fetched once
+    VkDeviceSize get_vertex_fetch_bytes(uint32_t vertex_size) const;
+
+    void clean_up_geometry_store();
 
-    void create_index_buf(const std::vector<uint16_t> &indices_dataset);
+    void bench_meshlets(const std::vector<VCW_Mesh> &loaded_meshes);
+
+    void create_objects(uint32_t count);
+
+    void set_object_count(uint32_t count);
+
+    void update_instance_buf(uint32_t frame);
+
+    void select_lods();
+
+    uint64_t get_submitted_triangles() const;
 
     void create_unif_bufs();
 
+    void start_prefetch();
+
+    void end_startup_stage(const char *name);
+
+    static VCW_ImageData load_img_data(const std::string &path);
+
+    VCW_Mesh load_mesh(const std::string &path);
+
     void create_tex_img();
 
     void create_depth_resources();
@@ -358,13 +1093,19 @@ public:
 
     void create_pipe();
 
-    void write_desc_pool();
+    void write_frame_desc_set(uint32_t frame);
 
     void update_bufs(uint32_t index_inflight_frame);
 
+    void begin_secondary_cmd_buf(VkCommandBuffer cmd_buf, uint32_t img_index);
+
+    void record_draws(VkCommandBuffer cmd_buf, size_t first_draw, size_t draw_count);
+
+    void record_draws_parallel(uint32_t img_index, std::vector<VkCommandBuffer> &secondaries);
+
     void record_cmd_buf(VkCommandBuffer cmd_buf, uint32_t img_index);
 
-    void fetch_queries(uint32_t img_index);
+    void fetch_queries(uint32_t slot);
 };
 
 const std::vector<Vertex> PLATE_SAMPLE_VERTICES = {{{-0.5f, -0.5f, 0.0f},  {1.0f, 0.0f}},
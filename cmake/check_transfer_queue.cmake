@@ -0,0 +1,38 @@
+# renders the same headless frames with the uploads on the transfer queue and on the graphics queue
+# and compares the read back pixels, run through the check_transfer_queue target
+if (NOT DEFINED FRAMES)
+    set(FRAMES 4)
+endif ()
+
+foreach (mode transfer_queue no_transfer_queue)
+    file(REMOVE_RECURSE ${OUT}/${mode})
+    file(MAKE_DIRECTORY ${OUT}/${mode})
+endforeach ()
+
+execute_process(COMMAND ${MAIN} --headless --frames ${FRAMES} --raw --out ${OUT}/transfer_queue
+        RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "headless run failed.")
+endif ()
+
+execute_process(COMMAND ${MAIN} --headless --frames ${FRAMES} --raw --out ${OUT}/no_transfer_queue --no-transfer-queue
+        RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "headless run with --no-transfer-queue failed.")
+endif ()
+
+file(GLOB frames RELATIVE ${OUT}/transfer_queue ${OUT}/transfer_queue/*.rgba)
+list(LENGTH frames frame_count)
+if (frame_count EQUAL 0)
+    message(FATAL_ERROR "no frames were read back.")
+endif ()
+
+foreach (frame ${frames})
+    execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${OUT}/transfer_queue/${frame}
+            ${OUT}/no_transfer_queue/${frame} RESULT_VARIABLE result)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "${frame} differs with --no-transfer-queue.")
+    endif ()
+endforeach ()
+
+message(STATUS "${frame_count} frames match with and without the transfer queue.")
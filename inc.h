@@ -25,8 +25,12 @@
 #include <array>
 #include <optional>
 #include <set>
+#include <deque>
+#include <unordered_map>
+#include <bit>
 #include <sstream>
 #include <functional>
+#include <filesystem>
 
 #include "imgui.h"
 #include "backends/imgui_impl_glfw.h"
@@ -3,10 +3,83 @@
 //
 #include "app.h"
 
-int main() {
+int main(int argc, char **argv) {
     App app;
 
     try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+
+            if (arg == "--headless")
+                app.headless = true;
+            else if (arg == "--frames" && i + 1 < argc)
+                app.headless_frame_count = static_cast<uint32_t>(std::stoul(argv[++i]));
+            else if (arg == "--out" && i + 1 < argc)
+                app.frame_out_dir = argv[++i];
+            else if (arg == "--raw")
+                app.frame_out_raw = true;
+            else if (arg == "--no-mips")
+                app.tex_mips = false;
+            else if (arg == "--texture" && i + 1 < argc)
+                app.tex_path = argv[++i];
+            else if (arg == "--stream" && i + 1 < argc)
+                app.stream_dir = argv[++i];
+            else if (arg == "--tex-budget" && i + 1 < argc)
+                app.tex_budget = std::stoull(argv[++i]) * 1024 * 1024;
+            else if (arg == "--no-transfer-queue")
+                app.transfer_queue = false;
+            else if (arg == "--desc-update" && i + 1 < argc) {
+                std::string mode = argv[++i];
+                if (mode == "writes")
+                    app.desc_update_mode = DESC_UPDATE_WRITES;
+                else if (mode == "template")
+                    app.desc_update_mode = DESC_UPDATE_TEMPLATE;
+                else if (mode == "push")
+                    app.desc_update_mode = DESC_UPDATE_PUSH;
+                else
+                    throw std::runtime_error("unknown descriptor update mode " + mode + ".");
+            } else if (arg == "--bench-desc" && i + 1 < argc)
+                app.desc_bench_iterations = static_cast<uint32_t>(std::stoul(argv[++i]));
+            else if (arg == "--objects" && i + 1 < argc)
+                app.object_count = static_cast<uint32_t>(std::stoul(argv[++i]));
+            else if (arg == "--cpu-draws")
+                app.gpu_cull = false;
+            else if (arg == "--no-cpu-cull")
+                app.cpu_cull = false;
+            else if (arg == "--bench-cull")
+                app.cull_bench = true;
+            else if (arg == "--stress" && i + 1 < argc)
+                app.stress_max = static_cast<uint32_t>(std::stoul(argv[++i]));
+            else if (arg == "--no-lod")
+                app.lods = false;
+            else if (arg == "--lod-error" && i + 1 < argc)
+                app.lod_pixel_error = std::stof(argv[++i]);
+            else if (arg == "--bench-lod")
+                app.lod_bench = true;
+            else if (arg == "--bench-meshlets")
+                app.meshlet_bench = true;
+            else if (arg == "--bench-mips")
+                app.mip_bench = true;
+            else if (arg == "--mesh" && i + 1 < argc)
+                app.mesh_paths.emplace_back(argv[++i]);
+            else if (arg == "--import" && i + 2 < argc) {
+                // converts and exits, nothing else is started
+                std::string src_path = argv[++i];
+                convert_mesh(src_path, argv[++i]);
+                return EXIT_SUCCESS;
+            } else if (arg == "--frames-in-flight" && i + 1 < argc)
+                app.frames_in_flight = static_cast<uint32_t>(std::stoul(argv[++i]));
+            else
+                throw std::runtime_error("unknown argument " + arg + ".");
+        }
+
+        if (app.frames_in_flight == 0)
+            throw std::runtime_error("frames in flight has to be at least 1.");
+        if (app.headless_frame_count == 0)
+            throw std::runtime_error("frame count has to be at least 1.");
+        if (app.object_count == 0)
+            throw std::runtime_error("object count has to be at least 1.");
+
         app.run();
     } catch (const std::exception &e) {
         std::cerr << e.what() << std::endl;
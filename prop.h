@@ -10,7 +10,26 @@
 #define INITIAL_WIDTH 800
 #define INITIAL_HEIGHT 600
 
-#define MAX_FRAMES_IN_FLIGHT 2
+// overridable with --frames-in-flight
+#define DEFAULT_FRAMES_IN_FLIGHT 2
+
+//
+// worker threads (0 = one less than hardware threads)
+//
+#define WORKER_THREAD_COUNT 0
+// the draw list is recorded into secondary command buffers on all threads from this length on
+#define PARALLEL_RECORD_MIN_DRAWS 256
+
+//
+// headless mode (--headless), renders into offscreen targets of this format
+//
+#define HEADLESS_FRAME_COUNT 1000
+const VkFormat HEADLESS_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
+//
+// pipeline cache, loaded at startup and written back at exit
+//
+#define PIPELINE_CACHE_FILE "pipeline_cache.bin"
 
 #define APP_NAME "Vulkan App"
 #define ENGINE_NAME "No Engine"
@@ -27,6 +46,12 @@ const std::vector<const char *> dev_exts = {
         // VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME // not required anymore
 };
 
+// enabled when the device supports them
+const std::vector<const char *> opt_dev_exts = {
+        VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+        VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME
+};
+
 //
 // scaling resolution
 //
@@ -39,6 +64,24 @@ const std::vector<const char *> dev_exts = {
 //
 // #define TESTING_COPY_INSTEAD_BLIT_IMG
 
+//
+// device memory is sub-allocated from blocks of this size,
+// resources larger than half a block get their own allocation
+//
+#define MEM_BLOCK_SIZE (64ull * 1024 * 1024)
+// share of a heap used as budget when VK_EXT_memory_budget is not available
+#define MEM_FALLBACK_BUDGET_PERCENT 80
+
+//
+// persistently mapped staging ring used by all uploads (power of two)
+//
+#define STAGING_RING_SIZE (16ull * 1024 * 1024)
+//
+// uploads run on a transfer-only (or async compute) queue family if the device has one,
+// define this to force the single queue path (e.g. to test what lavapipe does), --no-transfer-queue does so at runtime
+//
+// #define DISABLE_TRANSFER_QUEUE
+
 const VkFormat PREFERRED_FORMAT = VK_FORMAT_B8G8R8A8_SRGB;
 const VkColorSpaceKHR PREFERRED_COLOR_SPACE = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
 const VkPresentModeKHR PREFERRED_PRES_MODE = VK_PRESENT_MODE_FIFO_KHR;
@@ -66,6 +109,24 @@ const VkCullModeFlags CULL_MODE = VK_CULL_MODE_BACK_BIT;
 const VkFrontFace FRONT_FACE = VK_FRONT_FACE_CLOCKWISE;
 
 // #define BIND_SAMPLE_TEXTURE
+// overridable with --texture
+#define TEXTURE_PATH "textures/texture.jpg"
+// --bench-mips averages the generation time of both paths over this many runs
+#define MIP_BENCH_ITERATIONS 8
+
+//
+// texture streaming (--stream DIR)
+//
+// overridable with --tex-budget (MiB)
+#define TEXTURE_BUDGET (256ull * 1024 * 1024)
+// levels up to this size are uploaded first and always stay resident
+#define STREAM_TAIL_SIZE 64
+// rebuilding an image re-uploads all its resident levels, this bounds the staging traffic per frame
+#define STREAM_PROMOTIONS_PER_FRAME 4
+// streamed textures of a directory are lined up along -z in front of the camera
+#define STREAM_SPACING 4.0f
+#define STREAM_RADIUS 1.0f
+
 #define ENABLE_DEPTH_TESTING
 
 // #define ENABLE_UNIFORM
@@ -74,6 +135,126 @@ const VkShaderStageFlags UNIFORM_STAGE = VK_SHADER_STAGE_VERTEX_BIT;
 #define ENABLE_PUSH_CONSTANTS
 const VkShaderStageFlags PUSH_CONSTANTS_STAGE = VK_SHADER_STAGE_ALL_GRAPHICS;
 
+// one update after bind table of textures and storage buffers in set 1, draws pick their texture
+// through the tex_index push constant (needs USE_BINDLESS in shader.frag as well)
+// #define BINDLESS
+#define BINDLESS_MAX_TEXTURES 4096
+#define BINDLESS_MAX_BUFFERS 1024
+#if defined(BINDLESS) && !defined(ENABLE_PUSH_CONSTANTS)
+#error "BINDLESS passes texture indices as push constants."
+#endif
+
+// per draw data (VCW_ObjectUniform) is suballocated every frame from one persistently mapped buffer and bound
+// with a dynamic offset per draw (needs USE_DYNAMIC_UNIFORM in shader.vert as well)
+// #define ENABLE_DYNAMIC_UNIFORM
+// smallest region per frame, it grows to a slice per object
+#define DYNAMIC_UNIFORM_FRAME_SIZE (4ull*1024*1024)
+
+// the draw list lives in a storage buffer, a compute pass frustum culls it into indirect draws
+// (needs USE_GPU_DRIVEN in shader.vert as well), --cpu-draws records the same scene draw by draw instead
+// #define GPU_DRIVEN
+// local size of cull.comp
+#define CULL_GROUP_SIZE 64
+#if defined(GPU_DRIVEN) && defined(ENABLE_DYNAMIC_UNIFORM)
+#error "GPU_DRIVEN and ENABLE_DYNAMIC_UNIFORM both provide the per draw transform."
+#endif
+#if defined(GPU_DRIVEN) && !defined(ENABLE_PUSH_CONSTANTS)
+#error "GPU_DRIVEN culls against the view projection of the push constants."
+#endif
+// the culling pass tests every cluster of the visible instances against the frustum and its normal cone
+// and writes one indirect draw per surviving cluster (needs USE_MESHLETS in cull.comp as well)
+// #define MESHLETS
+#if defined(MESHLETS) && !defined(GPU_DRIVEN)
+#error "MESHLETS culls clusters in the GPU_DRIVEN culling pass."
+#endif
+
+// the objects become instances of one draw, their transform and material come from a per instance vertex stream
+// (needs USE_INSTANCING in shader.vert, and in shader.frag to sample the material's bindless texture)
+// #define INSTANCING
+#if defined(INSTANCING) && (defined(GPU_DRIVEN) || defined(ENABLE_DYNAMIC_UNIFORM))
+#error "INSTANCING, GPU_DRIVEN and ENABLE_DYNAMIC_UNIFORM each provide the per object transform."
+#endif
+
+// every streamed texture is drawn on an object of its own, which picks the texture by its bindless slot,
+// indirect draws share one texture, so GPU_DRIVEN builds only simulate the residency of --stream
+#if defined(BINDLESS) && !defined(GPU_DRIVEN)
+#define STREAM_DRAWS
+#endif
+
+// per draw data set, it follows the bindless table
+#ifdef BINDLESS
+#define OBJECT_SET 2
+#else
+#define OBJECT_SET 1
+#endif
+
+// copies of the mesh laid out in a lattice, overridable with --objects
+#define OBJECT_COUNT 1
+#define OBJECT_SPACING 3.0f
+// first object count of the headless --stress scene, doubled every step
+#define STRESS_MIN_OBJECTS 1024
+
+// scenes from this many objects are culled on all threads, in chunks of SCENE_CULL_CHUNK objects
+#define SCENE_CULL_PARALLEL_MIN 32768
+#define SCENE_CULL_CHUNK 16384
+// --bench-cull scatters the objects in a cube of this half extent around the camera
+#define SCENE_BENCH_EXTENT 500.0f
+// objects tested per path and scene size
+#define SCENE_BENCH_OBJECTS 20000000
+
+//
+// mesh import, see render/mesh.h
+//
+// fifo size of the simulated post transform cache the statistics are reported for
+#define MESH_CACHE_SIZE 16
+// lru size the vertex cache optimization scores against
+#define MESH_OPT_CACHE_SIZE 32
+// overdraw ordering is dropped if it raises the acmr by more than this factor
+#define MESH_OVERDRAW_THRESHOLD 1.05f
+// "VCWM"
+#define MESH_FILE_MAGIC 0x4D574356u
+#define MESH_FILE_VERSION 1
+#define GLTF_MAX_NODE_DEPTH 64
+// default size of the shared vertex and index buffers, larger startup meshes grow them to fit
+#define GEOMETRY_VERTEX_CAPACITY (64ull * 1024 * 1024)
+#define GEOMETRY_INDEX_CAPACITY (32ull * 1024 * 1024)
+
+// detail levels, see render/lod.h
+// levels per mesh including the full one
+#define LOD_MAX_LEVELS 5
+// triangle count of each level relative to the previous one
+#define LOD_REDUCTION 0.5f
+// no level is generated below this many triangles, or if it keeps more than LOD_MIN_SHRINK of the previous one
+#define LOD_MIN_TRIANGLES 32
+#define LOD_MIN_SHRINK 0.9f
+// objects take the coarsest level whose error stays below this many pixels on screen, overridable with --lod-error
+#define LOD_PIXEL_ERROR 1.0f
+// --bench-lod moves the camera this far behind the scene
+#define LOD_BENCH_DISTANCE 30.0f
+
+// clusters, see render/meshlet.h
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+// clusters whose normals spread further than this from their average are never cone culled
+#define MESHLET_CONE_MIN_DOT 0.1f
+// --bench-meshlets looks at every startup mesh from this many directions, this many radii from its center
+#define MESHLET_BENCH_VIEWS 64
+#define MESHLET_BENCH_DISTANCE 2.5f
+
+// vertex layout, see render/vertex_layout.h
+// positions become snorm16 scaled per mesh, uvs half floats and normals octahedral snorm16
+// (needs USE_QUANTIZED_VERTICES in shader.vert as well)
+// #define QUANTIZED_VERTICES
+// positions get a stream of their own, the other attributes follow in a second one
+// (there is no depth only pass yet, the split is measured for its memory and bandwidth only)
+// #define SPLIT_VERTEX_STREAMS
+#if defined(QUANTIZED_VERTICES) && !defined(ENABLE_PUSH_CONSTANTS)
+#error "QUANTIZED_VERTICES passes the per mesh dequantization as push constants."
+#endif
+#if defined(QUANTIZED_VERTICES) && defined(GPU_DRIVEN)
+#error "QUANTIZED_VERTICES pushes the dequantization per draw, indirect draws have no per draw push constants."
+#endif
+
 //
 // select which vertex set you want to use
 // just comment out the sets you do not want
@@ -86,6 +267,17 @@ const VkShaderStageFlags PUSH_CONSTANTS_STAGE = VK_SHADER_STAGE_ALL_GRAPHICS;
 #define IMPL_IMGUI
 #define IMGUI_DESCRIPTOR_COUNT 1
 
+//
+// per frame descriptor pools, a full pool is followed by one twice its size
+//
+#define DESC_POOL_INITIAL_SETS 64
+#define DESC_POOL_MAX_SETS 4096
+// how the per frame set is written (DESC_UPDATE_WRITES / _TEMPLATE / _PUSH), overridable with --desc-update,
+// push descriptors fall back to templates where VK_KHR_push_descriptor is missing
+#define DEFAULT_DESC_UPDATE_MODE DESC_UPDATE_TEMPLATE
+// uniform buffers in the set updated by --bench-desc
+#define DESC_BENCH_BINDINGS 8
+
 #define USE_CAMERA
 
 //
@@ -49,3 +49,16 @@ glm::mat4 VCW_Camera::get_view_proj() {
 
     return proj * view;
 }
+
+// left, right, bottom, top, near, far in world space, xyz is the normalized inward normal and w the distance
+std::array<glm::vec4, 6> VCW_Camera::get_frustum_planes() {
+    // rows of the view projection, clip space depth is zero to one
+    glm::mat4 rows = glm::transpose(get_view_proj());
+
+    std::array<glm::vec4, 6> planes = {rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+                                       rows[3] - rows[1], rows[2], rows[3] - rows[2]};
+    for (auto &plane: planes)
+        plane /= glm::length(glm::vec3(plane));
+
+    return planes;
+}
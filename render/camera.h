@@ -42,6 +42,8 @@ public:
     void update_cam_rotation(float dx, float dy);
 
     glm::mat4 get_view_proj();
+
+    std::array<glm::vec4, 6> get_frustum_planes();
 };
 
 #endif //VCW_CAMERA_H
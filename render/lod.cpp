@@ -0,0 +1,358 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "lod.h"
+
+#include <cmath>
+#include <numeric>
+
+// symmetric 4x4 quadric of weighted planes, error(p) = p^T A p + 2 b.p + c
+struct VCW_Quadric {
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c = 0.0;
+    double weight = 0.0;
+
+    void add_plane(glm::vec3 n, float d, double w) {
+        a00 += w * n.x * n.x;
+        a01 += w * n.x * n.y;
+        a02 += w * n.x * n.z;
+        a11 += w * n.y * n.y;
+        a12 += w * n.y * n.z;
+        a22 += w * n.z * n.z;
+        b0 += w * n.x * d;
+        b1 += w * n.y * d;
+        b2 += w * n.z * d;
+        c += w * d * d;
+        weight += w;
+    }
+
+    void add(const VCW_Quadric &q) {
+        a00 += q.a00;
+        a01 += q.a01;
+        a02 += q.a02;
+        a11 += q.a11;
+        a12 += q.a12;
+        a22 += q.a22;
+        b0 += q.b0;
+        b1 += q.b1;
+        b2 += q.b2;
+        c += q.c;
+        weight += q.weight;
+    }
+
+    // squared distance to the planes, averaged over their weights, only ranks the collapses
+    double eval(glm::vec3 p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double error = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                       2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return weight > 0.0 ? std::max(error, 0.0) / weight : 0.0;
+    }
+};
+
+struct VCW_Collapse {
+    double cost;
+    uint32_t from;
+    uint32_t to;
+};
+
+static glm::vec3 get_tri_normal(glm::vec3 a, glm::vec3 b, glm::vec3 c) {
+    return glm::cross(b - a, c - a);
+}
+
+// closest point by the voronoi region of p, see real-time collision detection 5.1.5
+static float get_tri_distance(glm::vec3 p, glm::vec3 a, glm::vec3 b, glm::vec3 c) {
+    glm::vec3 ab = b - a;
+    glm::vec3 ac = c - a;
+    glm::vec3 ap = p - a;
+    float d1 = glm::dot(ab, ap);
+    float d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return glm::length(ap);
+
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp);
+    float d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return glm::length(bp);
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return glm::length(p - (a + ab * (d1 / (d1 - d3))));
+
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp);
+    float d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return glm::length(cp);
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return glm::length(p - (a + ac * (d2 / (d2 - d6))));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+        return glm::length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+
+    float denom = va + vb + vc;
+    if (denom <= 0.0f)
+        return glm::length(ap);
+    return glm::length(p - (a + ab * (vb / denom) + ac * (vc / denom)));
+}
+
+// offsets and triangle ids around every welded vertex
+static void build_adjacency(const std::vector<uint32_t> &tris, const std::vector<uint32_t> &weld,
+                            std::vector<uint32_t> &adj_offsets, std::vector<uint32_t> &adj_tris) {
+    std::fill(adj_offsets.begin(), adj_offsets.end(), 0);
+    for (uint32_t index: tris)
+        adj_offsets[weld[index] + 1]++;
+    for (size_t v = 0; v + 1 < adj_offsets.size(); v++)
+        adj_offsets[v + 1] += adj_offsets[v];
+    adj_tris.resize(tris.size());
+
+    std::vector<uint32_t> fill(adj_offsets.begin(), adj_offsets.end() - 1);
+    for (size_t i = 0; i < tris.size(); i++)
+        adj_tris[fill[weld[tris[i]]]++] = static_cast<uint32_t>(i / 3);
+}
+
+std::vector<uint32_t> simplify_mesh(std::span<const Vertex> vertices, const std::vector<uint32_t> &indices,
+                                    size_t target_index_count, float *p_error) {
+    size_t vertex_count = vertices.size();
+
+    // vertices at the same position (uv seams) share one welded vertex, the lowest id
+    std::vector<uint32_t> weld(vertex_count);
+    std::vector<uint32_t> wedge_count(vertex_count, 0);
+    {
+        std::vector<uint32_t> order(vertex_count);
+        std::iota(order.begin(), order.end(), 0);
+        auto key = [&](uint32_t v) {
+            const glm::vec3 &p = vertices[v].pos;
+            return std::make_tuple(p.x, p.y, p.z, v);
+        };
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return key(a) < key(b); });
+        for (size_t i = 0; i < vertex_count; i++) {
+            uint32_t v = order[i];
+            bool same = i > 0 && vertices[order[i - 1]].pos == vertices[v].pos;
+            weld[v] = same ? weld[order[i - 1]] : v;
+            wedge_count[weld[v]]++;
+        }
+    }
+
+    std::vector<uint32_t> tris;
+    tris.reserve(indices.size());
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        if (weld[indices[i]] != weld[indices[i + 1]] && weld[indices[i + 1]] != weld[indices[i + 2]] &&
+            weld[indices[i]] != weld[indices[i + 2]])
+            tris.insert(tris.end(), {indices[i], indices[i + 1], indices[i + 2]});
+
+    // area weighted planes of the original triangles, merged along every collapse
+    std::vector<VCW_Quadric> quadrics(vertex_count);
+    for (size_t i = 0; i < tris.size(); i += 3) {
+        glm::vec3 p0 = vertices[tris[i]].pos;
+        glm::vec3 n = get_tri_normal(p0, vertices[tris[i + 1]].pos, vertices[tris[i + 2]].pos);
+        float area = glm::length(n);
+        if (area <= 0.0f)
+            continue;
+        n /= area;
+        for (size_t j = 0; j < 3; j++)
+            quadrics[weld[tris[i + j]]].add_plane(n, -glm::dot(n, p0), area);
+    }
+
+    // edges used by a single triangle are borders, moving their vertices would open or shrink the outline
+    std::vector<uint8_t> locked(vertex_count, 0);
+    {
+        std::vector<std::pair<uint32_t, uint32_t>> edges;
+        edges.reserve(tris.size());
+        for (size_t i = 0; i < tris.size(); i += 3)
+            for (size_t j = 0; j < 3; j++) {
+                uint32_t a = weld[tris[i + j]];
+                uint32_t b = weld[tris[i + (j + 1) % 3]];
+                edges.emplace_back(std::min(a, b), std::max(a, b));
+            }
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size();) {
+            size_t j = i;
+            while (j < edges.size() && edges[j] == edges[i])
+                j++;
+            if (j - i == 1) {
+                locked[edges[i].first] = 1;
+                locked[edges[i].second] = 1;
+            }
+            i = j;
+        }
+    }
+    for (size_t v = 0; v < vertex_count; v++)
+        if (wedge_count[weld[v]] > 1)
+            locked[weld[v]] = 1;
+
+    // the welded vertex every original position was merged into, for measuring the error at the end
+    std::vector<uint32_t> owner(weld);
+    std::vector<uint32_t> collapse_to(vertex_count);
+    std::vector<uint8_t> touched(vertex_count);
+    std::vector<uint32_t> adj_offsets(vertex_count + 1);
+    std::vector<uint32_t> adj_tris;
+
+    // every pass collapses the cheapest edges whose neighbourhoods do not overlap
+    while (tris.size() > target_index_count) {
+        std::vector<VCW_Collapse> collapses;
+        collapses.reserve(tris.size());
+        for (size_t i = 0; i < tris.size(); i += 3)
+            for (size_t j = 0; j < 3; j++) {
+                uint32_t a = weld[tris[i + j]];
+                uint32_t b = weld[tris[i + (j + 1) % 3]];
+                // each interior edge is seen from both of its triangles, once in every direction
+                if (locked[a])
+                    continue;
+                VCW_Quadric q = quadrics[a];
+                q.add(quadrics[b]);
+                collapses.push_back({q.eval(vertices[b].pos), a, b});
+            }
+        if (collapses.empty())
+            break;
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const VCW_Collapse &a, const VCW_Collapse &b) { return a.cost < b.cost; });
+
+        build_adjacency(tris, weld, adj_offsets, adj_tris);
+
+        std::iota(collapse_to.begin(), collapse_to.end(), 0);
+        std::fill(touched.begin(), touched.end(), 0);
+        size_t removed = 0;
+        size_t needed = (tris.size() - target_index_count + 2) / 3;
+
+        for (const auto &collapse: collapses) {
+            if (removed >= needed)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            // triangles that stay must not flip or collapse to a sliver. the moved vertex takes over the wedge of
+            // the target on their shared edge, if the target is a seam the edge has to pick one side of it
+            bool valid = true;
+            size_t tri_removed = 0;
+            uint32_t wedge = UINT32_MAX;
+            for (uint32_t k = adj_offsets[collapse.from]; k < adj_offsets[collapse.from + 1] && valid; k++) {
+                const uint32_t *p_tri = &tris[adj_tris[k] * 3];
+                glm::vec3 p[3];
+                glm::vec3 moved[3];
+                bool has_to = false;
+                for (size_t j = 0; j < 3; j++) {
+                    uint32_t w = weld[p_tri[j]];
+                    if (w == collapse.to) {
+                        has_to = true;
+                        valid = wedge == UINT32_MAX || wedge == p_tri[j];
+                        wedge = p_tri[j];
+                    }
+                    p[j] = vertices[w].pos;
+                    moved[j] = w == collapse.from ? vertices[collapse.to].pos : p[j];
+                }
+                if (has_to) {
+                    tri_removed++;
+                    continue;
+                }
+                glm::vec3 n0 = get_tri_normal(p[0], p[1], p[2]);
+                glm::vec3 n1 = get_tri_normal(moved[0], moved[1], moved[2]);
+                valid = glm::dot(n0, n1) > 0.25f * glm::length(n0) * glm::length(n1);
+            }
+            if (!valid || wedge == UINT32_MAX)
+                continue;
+
+            collapse_to[collapse.from] = wedge;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            removed += tri_removed;
+            for (uint32_t k = adj_offsets[collapse.from]; k < adj_offsets[collapse.from + 1]; k++)
+                for (size_t j = 0; j < 3; j++)
+                    touched[weld[tris[adj_tris[k] * 3 + j]]] = 1;
+        }
+        if (removed == 0)
+            break;
+
+        for (auto &w: owner)
+            if (collapse_to[w] != w)
+                w = weld[collapse_to[w]];
+
+        // a moved vertex is never a seam, so its only vertex takes the id of the target's wedge
+        size_t tri_count = 0;
+        for (size_t i = 0; i < tris.size(); i += 3) {
+            uint32_t tri[3];
+            for (size_t j = 0; j < 3; j++) {
+                uint32_t w = weld[tris[i + j]];
+                tri[j] = collapse_to[w] != w ? collapse_to[w] : tris[i + j];
+            }
+            if (weld[tri[0]] == weld[tri[1]] || weld[tri[1]] == weld[tri[2]] || weld[tri[0]] == weld[tri[2]])
+                continue;
+            std::copy(tri, tri + 3, tris.begin() + static_cast<ptrdiff_t>(tri_count * 3));
+            tri_count++;
+        }
+        tris.resize(tri_count * 3);
+    }
+
+    // every original position is measured against the triangles around the vertex it was merged into,
+    // this can only overestimate its distance to the simplified surface
+    if (p_error) {
+        build_adjacency(tris, weld, adj_offsets, adj_tris);
+        float max_error = 0.0f;
+        for (size_t v = 0; v < vertex_count; v++) {
+            uint32_t w = owner[v];
+            if (weld[v] != v || adj_offsets[w] == adj_offsets[w + 1])
+                continue;
+
+            float error = std::numeric_limits<float>::max();
+            for (uint32_t k = adj_offsets[w]; k < adj_offsets[w + 1]; k++) {
+                const uint32_t *p_tri = &tris[adj_tris[k] * 3];
+                error = std::min(error, get_tri_distance(vertices[v].pos, vertices[p_tri[0]].pos,
+                                                         vertices[p_tri[1]].pos, vertices[p_tri[2]].pos));
+            }
+            max_error = std::max(max_error, error);
+        }
+        *p_error = max_error;
+    }
+    return tris;
+}
+
+void generate_lods(VCW_Mesh &mesh) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    mesh.lods.clear();
+
+    std::vector<uint32_t> base(mesh.get_index_count());
+    for (size_t i = 0; i < base.size(); i++)
+        base[i] = mesh.get_index(i);
+
+    // every level starts over from the full mesh, so its error is measured against the original surface
+    size_t prev_count = base.size();
+    float prev_error = 0.0f;
+    for (uint32_t level = 1; level < LOD_MAX_LEVELS; level++) {
+        size_t target = static_cast<size_t>(static_cast<float>(prev_count / 3) * LOD_REDUCTION) * 3;
+        if (target < 3 * LOD_MIN_TRIANGLES)
+            break;
+
+        float error = 0.0f;
+        std::vector<uint32_t> indices = simplify_mesh(mesh.vertices, base, target, &error);
+        if (indices.empty() || static_cast<float>(indices.size()) > static_cast<float>(prev_count) * LOD_MIN_SHRINK)
+            break;
+
+        optimize_vertex_cache(indices, mesh.vertices.size());
+        prev_count = indices.size();
+        prev_error = std::max(prev_error, error);
+        mesh.lods.push_back({std::move(indices), prev_error});
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    mesh.lod_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+}
+
+float get_lod_pixel_scale(float fov, uint32_t height) {
+    return static_cast<float>(height) / (2.0f * std::tan(glm::radians(fov) / 2.0f));
+}
+
+uint32_t select_lod(std::span<const VCW_LodRange> lods, float distance, float pixel_scale, float max_pixel_error) {
+    // inside the bounds the full mesh is drawn
+    if (distance <= 0.0f)
+        return 0;
+
+    uint32_t lod = 0;
+    for (uint32_t i = 1; i < lods.size(); i++)
+        if (lods[i].error * pixel_scale / distance <= max_pixel_error)
+            lod = i;
+    return lod;
+}
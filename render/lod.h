@@ -0,0 +1,38 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#ifndef VCW_LOD_H
+#define VCW_LOD_H
+
+#include "../inc.h"
+#include "../prop.h"
+#include "mesh.h"
+
+#include <span>
+
+// a detail level's part of the geometry store, all levels of a mesh share its vertices
+struct VCW_LodRange {
+    uint32_t first_index;
+    uint32_t index_count;
+    // geometric deviation from the full mesh in object units
+    float error;
+};
+
+// quadric error metric edge collapse, vertices only move onto their neighbours, so no new vertices are created.
+// uv seams and open borders stay in place, the result has at most target_index_count indices if that is reachable
+// p_error receives the largest distance of an original vertex to the simplified surface
+std::vector<uint32_t> simplify_mesh(std::span<const Vertex> vertices, const std::vector<uint32_t> &indices,
+                                    size_t target_index_count, float *p_error);
+
+// fills mesh.lods with up to LOD_MAX_LEVELS - 1 levels of LOD_REDUCTION times the previous triangle count,
+// it stops early once a level no longer shrinks enough
+void generate_lods(VCW_Mesh &mesh);
+
+// pixels one object unit covers at distance one
+float get_lod_pixel_scale(float fov, uint32_t height);
+
+// the coarsest level whose error, projected at distance, stays below max_pixel_error
+uint32_t select_lod(std::span<const VCW_LodRange> lods, float distance, float pixel_scale, float max_pixel_error);
+
+#endif //VCW_LOD_H
@@ -0,0 +1,899 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "mesh.h"
+
+#include <cctype>
+#include <cmath>
+#include <numeric>
+
+VCW_Mesh::VCW_Mesh(std::vector<Vertex> mesh_vertices, const std::vector<uint16_t> &mesh_indices) {
+    vertex_storage = std::move(mesh_vertices);
+    index_storage.resize(sizeof(uint16_t) * mesh_indices.size());
+    memcpy(index_storage.data(), mesh_indices.data(), index_storage.size());
+    vertices = vertex_storage;
+    indices = index_storage;
+}
+
+VCW_Mesh::VCW_Mesh(std::vector<Vertex> mesh_vertices, const std::vector<uint32_t> &mesh_indices) {
+    vertex_storage = std::move(mesh_vertices);
+    if (vertex_storage.size() <= 65536) {
+        std::vector<uint16_t> narrow(mesh_indices.begin(), mesh_indices.end());
+        index_storage.resize(sizeof(uint16_t) * narrow.size());
+        memcpy(index_storage.data(), narrow.data(), index_storage.size());
+    } else {
+        index_size = 4;
+        index_storage.resize(sizeof(uint32_t) * mesh_indices.size());
+        memcpy(index_storage.data(), mesh_indices.data(), index_storage.size());
+    }
+    vertices = vertex_storage;
+    indices = index_storage;
+}
+
+uint32_t VCW_Mesh::get_index_count() const {
+    return static_cast<uint32_t>(indices.size() / index_size);
+}
+
+uint32_t VCW_Mesh::get_index(size_t i) const {
+    if (index_size == 2) {
+        uint16_t index;
+        memcpy(&index, indices.data() + i * 2, 2);
+        return index;
+    }
+    uint32_t index;
+    memcpy(&index, indices.data() + i * 4, 4);
+    return index;
+}
+
+//
+// obj, only positions, texture coordinates and faces are read, polygons are fanned into triangles
+//
+VCW_MeshData import_obj(const std::string &path) {
+    std::ifstream file(path);
+    if (!file.is_open())
+        throw std::runtime_error("failed to open mesh file.");
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvs;
+    VCW_MeshData mesh;
+
+    // 1 based, negative indices count back from the last element
+    auto resolve = [](long index, size_t count) -> size_t {
+        long resolved = index < 0 ? static_cast<long>(count) + index : index - 1;
+        if (resolved < 0 || static_cast<size_t>(resolved) >= count)
+            throw std::runtime_error("obj face index out of range.");
+        return static_cast<size_t>(resolved);
+    };
+
+    std::string line;
+    std::vector<Vertex> face;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::string keyword;
+        stream >> keyword;
+
+        if (keyword == "v") {
+            glm::vec3 pos(0.0f);
+            stream >> pos.x >> pos.y >> pos.z;
+            positions.push_back(pos);
+        } else if (keyword == "vt") {
+            glm::vec2 uv(0.0f);
+            stream >> uv.x >> uv.y;
+            // obj has v pointing up, vulkan samples from the top
+            uvs.emplace_back(uv.x, 1.0f - uv.y);
+        } else if (keyword == "f") {
+            // corners are v, v/vt, v//vn or v/vt/vn, every corner becomes a vertex until dedup_vertices
+            face.clear();
+            std::string corner;
+            while (stream >> corner) {
+                Vertex vertex{};
+                size_t slash = corner.find('/');
+                vertex.pos = positions[resolve(std::stol(corner.substr(0, slash)), positions.size())];
+                if (slash != std::string::npos && slash + 1 < corner.size() && corner[slash + 1] != '/')
+                    vertex.uv = uvs[resolve(std::stol(corner.substr(slash + 1)), uvs.size())];
+                face.push_back(vertex);
+            }
+
+            for (size_t i = 2; i < face.size(); i++) {
+                for (const Vertex &vertex: {face[0], face[i - 1], face[i]}) {
+                    mesh.indices.push_back(static_cast<uint32_t>(mesh.vertices.size()));
+                    mesh.vertices.push_back(vertex);
+                }
+            }
+        }
+    }
+
+    return mesh;
+}
+
+//
+// minimal json reader for gltf, numbers are doubles and objects keep their key order
+//
+struct VCW_Json {
+    enum Type {
+        JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT
+    } type = JSON_NULL;
+    double number = 0.0;
+    std::string string;
+    std::vector<VCW_Json> array;
+    std::vector<std::pair<std::string, VCW_Json>> object;
+
+    const VCW_Json *find(const std::string &key) const {
+        for (const auto &member: object)
+            if (member.first == key)
+                return &member.second;
+        return nullptr;
+    }
+
+    const VCW_Json &at(const std::string &key) const {
+        const VCW_Json *p_val = find(key);
+        if (!p_val)
+            throw std::runtime_error("gltf is missing " + key + ".");
+        return *p_val;
+    }
+
+    const VCW_Json &at(size_t index) const {
+        if (index >= array.size())
+            throw std::runtime_error("gltf index out of range.");
+        return array[index];
+    }
+
+    double get_number(const std::string &key, double fallback) const {
+        const VCW_Json *p_val = find(key);
+        return p_val ? p_val->number : fallback;
+    }
+};
+
+static void skip_ws(const std::string &text, size_t &pos) {
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos])))
+        pos++;
+}
+
+static std::string parse_json_string(const std::string &text, size_t &pos) {
+    std::string result;
+    for (pos++; pos < text.size() && text[pos] != '"'; pos++) {
+        if (text[pos] != '\\') {
+            result += text[pos];
+            continue;
+        }
+
+        pos++;
+        if (pos >= text.size())
+            break;
+        switch (text[pos]) {
+            case 'n':
+                result += '\n';
+                break;
+            case 't':
+                result += '\t';
+                break;
+            case 'r':
+                result += '\r';
+                break;
+            case 'b':
+                result += '\b';
+                break;
+            case 'f':
+                result += '\f';
+                break;
+            case 'u': {
+                // only needed for names, code points are written as utf-8 without surrogate pairing
+                uint32_t code = std::stoul(text.substr(pos + 1, 4), nullptr, 16);
+                pos += 4;
+                if (code < 0x80) {
+                    result += static_cast<char>(code);
+                } else if (code < 0x800) {
+                    result += static_cast<char>(0xC0 | code >> 6);
+                    result += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    result += static_cast<char>(0xE0 | code >> 12);
+                    result += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+                    result += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default:
+                result += text[pos];
+        }
+    }
+
+    if (pos >= text.size())
+        throw std::runtime_error("unterminated json string.");
+    pos++;
+    return result;
+}
+
+static VCW_Json parse_json(const std::string &text, size_t &pos) {
+    skip_ws(text, pos);
+    if (pos >= text.size())
+        throw std::runtime_error("unexpected end of json.");
+
+    VCW_Json val;
+    char c = text[pos];
+    if (c == '{') {
+        val.type = VCW_Json::JSON_OBJECT;
+        pos++;
+        skip_ws(text, pos);
+        while (pos < text.size() && text[pos] != '}') {
+            skip_ws(text, pos);
+            std::string key = parse_json_string(text, pos);
+            skip_ws(text, pos);
+            if (pos >= text.size() || text[pos] != ':')
+                throw std::runtime_error("expected : in json object.");
+            pos++;
+            val.object.emplace_back(key, parse_json(text, pos));
+            skip_ws(text, pos);
+            if (pos < text.size() && text[pos] == ',')
+                pos++;
+            skip_ws(text, pos);
+        }
+        pos++;
+    } else if (c == '[') {
+        val.type = VCW_Json::JSON_ARRAY;
+        pos++;
+        skip_ws(text, pos);
+        while (pos < text.size() && text[pos] != ']') {
+            val.array.push_back(parse_json(text, pos));
+            skip_ws(text, pos);
+            if (pos < text.size() && text[pos] == ',')
+                pos++;
+            skip_ws(text, pos);
+        }
+        pos++;
+    } else if (c == '"') {
+        val.type = VCW_Json::JSON_STRING;
+        val.string = parse_json_string(text, pos);
+    } else if (text.compare(pos, 4, "true") == 0 || text.compare(pos, 5, "false") == 0) {
+        val.type = VCW_Json::JSON_BOOL;
+        val.number = c == 't' ? 1.0 : 0.0;
+        pos += c == 't' ? 4 : 5;
+    } else if (text.compare(pos, 4, "null") == 0) {
+        pos += 4;
+    } else {
+        val.type = VCW_Json::JSON_NUMBER;
+        char *p_end;
+        val.number = std::strtod(text.c_str() + pos, &p_end);
+        if (p_end == text.c_str() + pos)
+            throw std::runtime_error("invalid json value.");
+        pos = static_cast<size_t>(p_end - text.c_str());
+    }
+
+    return val;
+}
+
+static std::vector<char> decode_base64(const std::string &text) {
+    auto decode_char = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+') return 62;
+        if (c == '/') return 63;
+        return -1;
+    };
+
+    std::vector<char> data;
+    uint32_t bits = 0;
+    int bit_count = 0;
+    for (char c: text) {
+        int val = decode_char(c);
+        if (val < 0)
+            continue;
+        bits = bits << 6 | static_cast<uint32_t>(val);
+        bit_count += 6;
+        if (bit_count >= 8) {
+            bit_count -= 8;
+            data.push_back(static_cast<char>(bits >> bit_count & 0xFF));
+        }
+    }
+    return data;
+}
+
+struct VCW_Gltf {
+    VCW_Json json;
+    std::vector<std::vector<char>> buffers;
+
+    // elements of an accessor as floats, normalized integers are mapped to [0, 1]
+    std::vector<float> read_floats(size_t accessor_index, uint32_t component_count) const;
+
+    std::vector<uint32_t> read_indices(size_t accessor_index) const;
+
+private:
+    const char *get_element(const VCW_Json &accessor, size_t element, size_t element_size) const;
+};
+
+const char *VCW_Gltf::get_element(const VCW_Json &accessor, size_t element, size_t element_size) const {
+    if (accessor.find("sparse"))
+        throw std::runtime_error("sparse gltf accessors are not supported.");
+
+    const VCW_Json &view = json.at("bufferViews").at(static_cast<size_t>(accessor.at("bufferView").number));
+    const std::vector<char> &buffer = buffers.at(static_cast<size_t>(view.at("buffer").number));
+    size_t stride = static_cast<size_t>(view.get_number("byteStride", 0.0));
+    size_t offset = static_cast<size_t>(view.get_number("byteOffset", 0.0) + accessor.get_number("byteOffset", 0.0)) +
+                    element * (stride ? stride : element_size);
+
+    if (offset + element_size > buffer.size())
+        throw std::runtime_error("gltf accessor exceeds its buffer.");
+    return buffer.data() + offset;
+}
+
+std::vector<float> VCW_Gltf::read_floats(size_t accessor_index, uint32_t component_count) const {
+    const VCW_Json &accessor = json.at("accessors").at(accessor_index);
+    auto component_type = static_cast<uint32_t>(accessor.at("componentType").number);
+    auto count = static_cast<size_t>(accessor.at("count").number);
+
+    // 5126 float, 5121 unsigned byte, 5123 unsigned short
+    size_t component_size = component_type == 5126 ? 4 : component_type == 5123 ? 2 : component_type == 5121 ? 1 : 0;
+    if (component_size == 0)
+        throw std::runtime_error("unsupported gltf vertex component type.");
+
+    std::vector<float> values(count * component_count);
+    for (size_t i = 0; i < count; i++) {
+        const char *p_element = get_element(accessor, i, component_size * component_count);
+        for (uint32_t c = 0; c < component_count; c++) {
+            float &val = values[i * component_count + c];
+            if (component_type == 5126) {
+                memcpy(&val, p_element + c * 4, 4);
+            } else if (component_type == 5123) {
+                uint16_t raw;
+                memcpy(&raw, p_element + c * 2, 2);
+                val = static_cast<float>(raw) / 65535.0f;
+            } else {
+                val = static_cast<float>(static_cast<uint8_t>(p_element[c])) / 255.0f;
+            }
+        }
+    }
+    return values;
+}
+
+std::vector<uint32_t> VCW_Gltf::read_indices(size_t accessor_index) const {
+    const VCW_Json &accessor = json.at("accessors").at(accessor_index);
+    auto component_type = static_cast<uint32_t>(accessor.at("componentType").number);
+    auto count = static_cast<size_t>(accessor.at("count").number);
+
+    // 5121 unsigned byte, 5123 unsigned short, 5125 unsigned int
+    size_t index_size = component_type == 5125 ? 4 : component_type == 5123 ? 2 : component_type == 5121 ? 1 : 0;
+    if (index_size == 0)
+        throw std::runtime_error("unsupported gltf index type.");
+
+    std::vector<uint32_t> indices(count);
+    for (size_t i = 0; i < count; i++) {
+        const char *p_element = get_element(accessor, i, index_size);
+        uint32_t index = 0;
+        memcpy(&index, p_element, index_size);
+        indices[i] = index;
+    }
+    return indices;
+}
+
+// gltf matrices are column major like glm's
+static glm::mat4 get_node_transform(const VCW_Json &node) {
+    if (const VCW_Json *p_matrix = node.find("matrix")) {
+        glm::mat4 matrix;
+        for (int i = 0; i < 16; i++)
+            matrix[i / 4][i % 4] = static_cast<float>(p_matrix->at(i).number);
+        return matrix;
+    }
+
+    glm::mat4 transform(1.0f);
+    if (const VCW_Json *p_t = node.find("translation"))
+        transform = glm::translate(transform, glm::vec3(p_t->at(0).number, p_t->at(1).number, p_t->at(2).number));
+    if (const VCW_Json *p_r = node.find("rotation")) {
+        float x = static_cast<float>(p_r->at(0).number);
+        float y = static_cast<float>(p_r->at(1).number);
+        float z = static_cast<float>(p_r->at(2).number);
+        float w = static_cast<float>(p_r->at(3).number);
+        glm::mat4 rotation(1.0f);
+        rotation[0] = {1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w), 0};
+        rotation[1] = {2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w), 0};
+        rotation[2] = {2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y), 0};
+        transform *= rotation;
+    }
+    if (const VCW_Json *p_s = node.find("scale"))
+        transform = glm::scale(transform, glm::vec3(p_s->at(0).number, p_s->at(1).number, p_s->at(2).number));
+    return transform;
+}
+
+static void append_gltf_mesh(const VCW_Gltf &gltf, size_t mesh_index, const glm::mat4 &transform,
+                             VCW_MeshData &mesh) {
+    const VCW_Json &gltf_mesh = gltf.json.at("meshes").at(mesh_index);
+    for (const VCW_Json &primitive: gltf_mesh.at("primitives").array) {
+        // 4 is a triangle list, points, lines and strips are left out
+        if (primitive.get_number("mode", 4.0) != 4.0)
+            continue;
+
+        const VCW_Json &attributes = primitive.at("attributes");
+        std::vector<float> positions = gltf.read_floats(static_cast<size_t>(attributes.at("POSITION").number), 3);
+        std::vector<float> uvs;
+        if (const VCW_Json *p_uv = attributes.find("TEXCOORD_0"))
+            uvs = gltf.read_floats(static_cast<size_t>(p_uv->number), 2);
+
+        size_t vertex_count = positions.size() / 3;
+        std::vector<uint32_t> indices;
+        if (const VCW_Json *p_indices = primitive.find("indices")) {
+            indices = gltf.read_indices(static_cast<size_t>(p_indices->number));
+        } else {
+            indices.resize(vertex_count);
+            std::iota(indices.begin(), indices.end(), 0u);
+        }
+
+        auto base = static_cast<uint32_t>(mesh.vertices.size());
+        for (size_t i = 0; i < vertex_count; i++) {
+            Vertex vertex{};
+            vertex.pos = glm::vec3(transform * glm::vec4(positions[i * 3], positions[i * 3 + 1],
+                                                         positions[i * 3 + 2], 1.0f));
+            if (!uvs.empty())
+                vertex.uv = {uvs[i * 2], uvs[i * 2 + 1]};
+            mesh.vertices.push_back(vertex);
+        }
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            if (indices[i] >= vertex_count || indices[i + 1] >= vertex_count || indices[i + 2] >= vertex_count)
+                throw std::runtime_error("gltf index out of range.");
+            mesh.indices.insert(mesh.indices.end(), {base + indices[i], base + indices[i + 1], base + indices[i + 2]});
+        }
+    }
+}
+
+static void append_gltf_node(const VCW_Gltf &gltf, size_t node_index, const glm::mat4 &parent, VCW_MeshData &mesh,
+                             uint32_t depth) {
+    if (depth > GLTF_MAX_NODE_DEPTH)
+        throw std::runtime_error("gltf node hierarchy is too deep.");
+
+    const VCW_Json &node = gltf.json.at("nodes").at(node_index);
+    glm::mat4 transform = parent * get_node_transform(node);
+
+    if (const VCW_Json *p_mesh = node.find("mesh"))
+        append_gltf_mesh(gltf, static_cast<size_t>(p_mesh->number), transform, mesh);
+    if (const VCW_Json *p_children = node.find("children"))
+        for (const VCW_Json &child: p_children->array)
+            append_gltf_node(gltf, static_cast<size_t>(child.number), transform, mesh, depth + 1);
+}
+
+//
+// gltf 2.0 (.gltf with external or base64 buffers, or .glb), the triangle primitives of the default scene
+// are flattened into one mesh with their node transforms applied, materials are ignored
+//
+VCW_MeshData import_gltf(const std::string &path) {
+    std::vector<char> data = read_file(path);
+    std::filesystem::path dir = std::filesystem::path(path).parent_path();
+
+    VCW_Gltf gltf;
+    std::string json_text;
+    std::vector<char> glb_bin;
+
+    // glb: 12 byte header, then a json chunk and an optional binary chunk
+    if (data.size() >= 12 && memcmp(data.data(), "glTF", 4) == 0) {
+        size_t offset = 12;
+        while (offset + 8 <= data.size()) {
+            uint32_t chunk_length, chunk_type;
+            memcpy(&chunk_length, data.data() + offset, 4);
+            memcpy(&chunk_type, data.data() + offset + 4, 4);
+            if (offset + 8 + chunk_length > data.size())
+                throw std::runtime_error("glb chunk is truncated.");
+
+            const char *p_chunk = data.data() + offset + 8;
+            if (chunk_type == 0x4E4F534A) // JSON
+                json_text.assign(p_chunk, chunk_length);
+            else if (chunk_type == 0x004E4942) // BIN
+                glb_bin.assign(p_chunk, p_chunk + chunk_length);
+            offset += 8 + chunk_length;
+        }
+    } else {
+        json_text.assign(data.begin(), data.end());
+    }
+
+    size_t pos = 0;
+    gltf.json = parse_json(json_text, pos);
+
+    if (const VCW_Json *p_buffers = gltf.json.find("buffers")) {
+        for (const VCW_Json &buffer: p_buffers->array) {
+            const VCW_Json *p_uri = buffer.find("uri");
+            if (!p_uri) {
+                gltf.buffers.push_back(std::move(glb_bin));
+            } else if (p_uri->string.rfind("data:", 0) == 0) {
+                gltf.buffers.push_back(decode_base64(p_uri->string.substr(p_uri->string.find(',') + 1)));
+            } else {
+                gltf.buffers.push_back(read_file((dir / p_uri->string).string()));
+            }
+        }
+    }
+
+    VCW_MeshData mesh;
+    const VCW_Json *p_scenes = gltf.json.find("scenes");
+    if (p_scenes && !p_scenes->array.empty()) {
+        const VCW_Json &scene = p_scenes->at(static_cast<size_t>(gltf.json.get_number("scene", 0.0)));
+        if (const VCW_Json *p_nodes = scene.find("nodes"))
+            for (const VCW_Json &node: p_nodes->array)
+                append_gltf_node(gltf, static_cast<size_t>(node.number), glm::mat4(1.0f), mesh, 0);
+    } else if (const VCW_Json *p_meshes = gltf.json.find("meshes")) {
+        // no scene, every mesh is taken as is
+        for (size_t i = 0; i < p_meshes->array.size(); i++)
+            append_gltf_mesh(gltf, i, glm::mat4(1.0f), mesh);
+    }
+
+    return mesh;
+}
+
+VCW_MeshData import_mesh(const std::string &path) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    if (ext == ".obj")
+        return import_obj(path);
+    if (ext == ".gltf" || ext == ".glb")
+        return import_gltf(path);
+    throw std::runtime_error("unsupported mesh format " + ext + ".");
+}
+
+struct VCW_VertexHash {
+    size_t operator()(const Vertex &vertex) const {
+        uint32_t words[5];
+        memcpy(words, &vertex, sizeof(words));
+        size_t hash = 0;
+        for (uint32_t word: words)
+            hash = hash * 31 + std::hash<uint32_t>()(word);
+        return hash;
+    }
+};
+
+struct VCW_VertexEqual {
+    bool operator()(const Vertex &a, const Vertex &b) const {
+        return memcmp(&a, &b, sizeof(Vertex)) == 0;
+    }
+};
+
+// bitwise equal vertices are merged, the first occurrence keeps its place
+void dedup_vertices(VCW_MeshData &mesh) {
+    static_assert(sizeof(Vertex) == 20, "VCW_VertexHash reads the vertex as 5 words.");
+
+    std::unordered_map<Vertex, uint32_t, VCW_VertexHash, VCW_VertexEqual> unique;
+    unique.reserve(mesh.vertices.size());
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> remap(mesh.vertices.size());
+
+    for (size_t i = 0; i < mesh.vertices.size(); i++) {
+        auto [it, inserted] = unique.try_emplace(mesh.vertices[i], static_cast<uint32_t>(vertices.size()));
+        if (inserted)
+            vertices.push_back(mesh.vertices[i]);
+        remap[i] = it->second;
+    }
+
+    for (uint32_t &index: mesh.indices)
+        index = remap[index];
+    mesh.vertices = std::move(vertices);
+}
+
+//
+// linear speed vertex cache optimization (Forsyth), greedily emits the triangle whose vertices score highest,
+// vertices score for being recently used and for having few triangles left
+//
+static float get_vertex_score(int cache_pos, uint32_t remaining) {
+    if (remaining == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cache_pos >= 0) {
+        // the last triangle's vertices are scored lower so the next one does not simply reuse its edge
+        if (cache_pos < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - static_cast<float>(cache_pos - 3) / (MESH_OPT_CACHE_SIZE - 3), 1.5f);
+    }
+    return score + 2.0f / std::sqrt(static_cast<float>(remaining));
+}
+
+void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count) {
+    size_t tri_count = indices.size() / 3;
+    if (tri_count == 0)
+        return;
+
+    // triangles of each vertex, the first remaining[v] entries are the ones not emitted yet
+    std::vector<uint32_t> remaining(vertex_count, 0);
+    for (uint32_t index: indices)
+        remaining[index]++;
+    std::vector<uint32_t> adj_offsets(vertex_count + 1, 0);
+    for (size_t v = 0; v < vertex_count; v++)
+        adj_offsets[v + 1] = adj_offsets[v] + remaining[v];
+    std::vector<uint32_t> adj(indices.size());
+    std::vector<uint32_t> fill(adj_offsets.begin(), adj_offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++)
+        adj[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+    std::vector<int> cache_pos(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++)
+        vertex_score[v] = get_vertex_score(-1, remaining[v]);
+
+    std::vector<float> tri_score(tri_count);
+    std::vector<uint8_t> emitted(tri_count, 0);
+    for (size_t t = 0; t < tri_count; t++)
+        tri_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] +
+                       vertex_score[indices[t * 3 + 2]];
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> new_cache;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    size_t next_unemitted = 0;
+
+    auto best_tri = static_cast<uint32_t>(std::max_element(tri_score.begin(), tri_score.end()) - tri_score.begin());
+    while (result.size() < indices.size()) {
+        emitted[best_tri] = 1;
+        const uint32_t *p_tri = &indices[best_tri * 3];
+        result.insert(result.end(), p_tri, p_tri + 3);
+
+        // the triangle's vertices move to the front, the rest of the cache follows
+        new_cache.assign(p_tri, p_tri + 3);
+        for (uint32_t v: cache)
+            if (v != p_tri[0] && v != p_tri[1] && v != p_tri[2])
+                new_cache.push_back(v);
+
+        for (int c = 0; c < 3; c++) {
+            uint32_t v = p_tri[c];
+            uint32_t *p_adj = &adj[adj_offsets[v]];
+            for (uint32_t a = 0; a < remaining[v]; a++) {
+                if (p_adj[a] == best_tri) {
+                    p_adj[a] = p_adj[remaining[v] - 1];
+                    remaining[v]--;
+                    break;
+                }
+            }
+        }
+
+        // vertices pushed out of the cache lose their cache score
+        for (size_t c = 0; c < new_cache.size(); c++) {
+            uint32_t v = new_cache[c];
+            cache_pos[v] = c < MESH_OPT_CACHE_SIZE ? static_cast<int>(c) : -1;
+            vertex_score[v] = get_vertex_score(cache_pos[v], remaining[v]);
+        }
+
+        float best_score = -1.0f;
+        for (size_t c = 0; c < new_cache.size(); c++) {
+            uint32_t v = new_cache[c];
+            for (uint32_t a = 0; a < remaining[v]; a++) {
+                uint32_t t = adj[adj_offsets[v] + a];
+                tri_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] +
+                               vertex_score[indices[t * 3 + 2]];
+                if (tri_score[t] > best_score) {
+                    best_score = tri_score[t];
+                    best_tri = t;
+                }
+            }
+        }
+
+        if (new_cache.size() > MESH_OPT_CACHE_SIZE)
+            new_cache.resize(MESH_OPT_CACHE_SIZE);
+        std::swap(cache, new_cache);
+
+        // nothing left around the cache, continue with the next triangle in input order
+        if (best_score < 0.0f) {
+            while (next_unemitted < tri_count && emitted[next_unemitted])
+                next_unemitted++;
+            if (next_unemitted == tri_count)
+                break;
+            best_tri = static_cast<uint32_t>(next_unemitted);
+        }
+    }
+
+    indices = std::move(result);
+}
+
+//
+// overdraw (Sander et al., fast triangle reordering), the cache optimized order is cut into clusters where
+// the cache starts over and the clusters facing outwards are drawn first, so they occlude the rest early
+//
+void optimize_overdraw(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices) {
+    size_t tri_count = indices.size() / 3;
+    if (tri_count == 0)
+        return;
+
+    // a cluster starts with a triangle that misses the simulated cache with all three vertices
+    std::vector<size_t> cluster_starts;
+    std::vector<uint32_t> stamps(vertices.size(), 0);
+    uint32_t misses = MESH_CACHE_SIZE + 1;
+    for (size_t t = 0; t < tri_count; t++) {
+        uint32_t tri_misses = 0;
+        for (int c = 0; c < 3; c++) {
+            uint32_t v = indices[t * 3 + c];
+            if (misses - stamps[v] > MESH_CACHE_SIZE) {
+                stamps[v] = ++misses;
+                tri_misses++;
+            }
+        }
+        if (tri_misses == 3 || t == 0)
+            cluster_starts.push_back(t);
+    }
+    cluster_starts.push_back(tri_count);
+
+    glm::vec3 mesh_center(0.0f);
+    for (const Vertex &vertex: vertices)
+        mesh_center += vertex.pos;
+    mesh_center /= static_cast<float>(vertices.size());
+
+    // area weighted centroid and normal of each cluster
+    size_t cluster_count = cluster_starts.size() - 1;
+    std::vector<float> sort_keys(cluster_count);
+    for (size_t c = 0; c < cluster_count; c++) {
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area_sum = 0.0f;
+        for (size_t t = cluster_starts[c]; t < cluster_starts[c + 1]; t++) {
+            glm::vec3 p0 = vertices[indices[t * 3]].pos;
+            glm::vec3 p1 = vertices[indices[t * 3 + 1]].pos;
+            glm::vec3 p2 = vertices[indices[t * 3 + 2]].pos;
+            glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(cross);
+            centroid += (p0 + p1 + p2) * (area / 3.0f);
+            normal += cross;
+            area_sum += area;
+        }
+        if (area_sum > 0.0f)
+            centroid /= area_sum;
+        float normal_length = glm::length(normal);
+        sort_keys[c] = normal_length > 0.0f ? glm::dot(centroid - mesh_center, normal / normal_length) : 0.0f;
+    }
+
+    std::vector<size_t> order(cluster_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sort_keys[a] > sort_keys[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (size_t c: order)
+        result.insert(result.end(), indices.begin() + static_cast<std::ptrdiff_t>(cluster_starts[c] * 3),
+                      indices.begin() + static_cast<std::ptrdiff_t>(cluster_starts[c + 1] * 3));
+
+    // reordering clusters only costs the misses at their seams, the cache order is kept if it costs more
+    if (get_acmr(result, vertices.size(), MESH_CACHE_SIZE) <=
+        get_acmr(indices, vertices.size(), MESH_CACHE_SIZE) * MESH_OVERDRAW_THRESHOLD)
+        indices = std::move(result);
+}
+
+// vertices are renumbered in the order the indices first use them, unused ones are dropped
+void optimize_vertex_fetch(VCW_MeshData &mesh) {
+    std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    for (uint32_t &index: mesh.indices) {
+        if (remap[index] == UINT32_MAX) {
+            remap[index] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices = std::move(vertices);
+}
+
+// fifo post transform cache of cache_size vertices, misses per triangle
+float get_acmr(const std::vector<uint32_t> &indices, size_t vertex_count, uint32_t cache_size) {
+    if (indices.size() < 3)
+        return 0.0f;
+
+    // a vertex is cached if fewer than cache_size misses happened since it was loaded
+    std::vector<uint32_t> stamps(vertex_count, 0);
+    uint32_t misses = cache_size + 1;
+    uint32_t start = misses;
+    for (uint32_t index: indices) {
+        if (misses - stamps[index] > cache_size)
+            stamps[index] = ++misses;
+    }
+    return static_cast<float>(misses - start) / static_cast<float>(indices.size() / 3);
+}
+
+VCW_MeshStats optimize_mesh(VCW_MeshData &mesh) {
+    VCW_MeshStats stats{};
+    stats.src_vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    dedup_vertices(mesh);
+    stats.acmr_before = get_acmr(mesh.indices, mesh.vertices.size(), MESH_CACHE_SIZE);
+
+    optimize_vertex_cache(mesh.indices, mesh.vertices.size());
+    optimize_overdraw(mesh.indices, mesh.vertices);
+    optimize_vertex_fetch(mesh);
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    stats.optimize_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    stats.acmr_after = get_acmr(mesh.indices, mesh.vertices.size(), MESH_CACHE_SIZE);
+    return stats;
+}
+
+VCW_Mesh create_mesh(VCW_MeshData &&mesh) {
+    return {std::move(mesh.vertices), mesh.indices};
+}
+
+void write_mesh_file(const std::string &path, const VCW_MeshData &mesh) {
+    VCW_MeshFileHeader header{};
+    header.magic = MESH_FILE_MAGIC;
+    header.version = MESH_FILE_VERSION;
+    header.vertex_size = sizeof(Vertex);
+    header.vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+    header.index_size = mesh.vertices.size() <= 65536 ? 2 : 4;
+    header.index_count = static_cast<uint32_t>(mesh.indices.size());
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("failed to create mesh file.");
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(mesh.vertices.data()),
+               static_cast<std::streamsize>(sizeof(Vertex) * mesh.vertices.size()));
+    if (header.index_size == 2) {
+        std::vector<uint16_t> indices(mesh.indices.begin(), mesh.indices.end());
+        file.write(reinterpret_cast<const char *>(indices.data()),
+                   static_cast<std::streamsize>(sizeof(uint16_t) * indices.size()));
+    } else {
+        file.write(reinterpret_cast<const char *>(mesh.indices.data()),
+                   static_cast<std::streamsize>(sizeof(uint32_t) * mesh.indices.size()));
+    }
+
+    if (!file)
+        throw std::runtime_error("failed to write mesh file.");
+}
+
+// nothing is copied, the spans point into the mapping and the upload reads straight from it,
+// only the indices are read once to check them
+VCW_Mesh load_mesh_file(const std::string &path) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    VCW_Mesh mesh;
+    mesh.p_file = std::make_shared<VCW_MappedFile>();
+    mesh.p_file->open(path);
+
+    VCW_MeshFileHeader header{};
+    if (mesh.p_file->size < sizeof(header))
+        throw std::runtime_error("mesh file is truncated.");
+    memcpy(&header, mesh.p_file->p_data, sizeof(header));
+
+    if (header.magic != MESH_FILE_MAGIC || header.version != MESH_FILE_VERSION || header.vertex_size != sizeof(Vertex))
+        throw std::runtime_error("mesh file has an unknown format or version.");
+    if (header.index_size != 2 && header.index_size != 4)
+        throw std::runtime_error("mesh file has an invalid index size.");
+
+    size_t vertex_bytes = sizeof(Vertex) * header.vertex_count;
+    size_t index_bytes = static_cast<size_t>(header.index_size) * header.index_count;
+    if (sizeof(header) + vertex_bytes + index_bytes > mesh.p_file->size)
+        throw std::runtime_error("mesh file is truncated.");
+
+    // the header and vertices are multiples of 4 bytes, so both arrays are aligned within the page aligned mapping
+    const char *p_vertices = mesh.p_file->p_data + sizeof(header);
+    mesh.vertices = {reinterpret_cast<const Vertex *>(p_vertices), header.vertex_count};
+    mesh.indices = {p_vertices + vertex_bytes, index_bytes};
+    mesh.index_size = header.index_size;
+
+    // the indices address cpu arrays during lod and meshlet generation, so a corrupt file must not get through
+    if (header.index_count % 3 != 0)
+        throw std::runtime_error("mesh file has an incomplete triangle.");
+    for (uint32_t i = 0; i < header.index_count; i++)
+        if (mesh.get_index(i) >= header.vertex_count)
+            throw std::runtime_error("mesh file index out of range.");
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    mesh.load_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+
+    return mesh;
+}
+
+void convert_mesh(const std::string &src_path, const std::string &dst_path) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    VCW_MeshData mesh = import_mesh(src_path);
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    VCW_MeshStats stats = optimize_mesh(mesh);
+    stats.import_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    write_mesh_file(dst_path, mesh);
+
+    std::cout << "imported " << src_path << " in " << stats.import_time << "ms: " << stats.src_vertex_count
+              << " vertices, " << mesh.vertices.size() << " after dedup, " << mesh.indices.size() / 3 << " triangles"
+              << std::endl;
+    std::cout << "optimized in " << stats.optimize_time << "ms, acmr " << stats.acmr_before << " -> "
+              << stats.acmr_after << " (cache miss ratio " << stats.acmr_before / 3.0f * 100.0f << "% -> "
+              << stats.acmr_after / 3.0f * 100.0f << "%, " << MESH_CACHE_SIZE << " entry fifo)" << std::endl;
+    std::cout << "wrote " << dst_path << ": " << (std::filesystem::file_size(dst_path) + 1023) / 1024 << " KiB"
+              << std::endl;
+
+    // the first load after writing is served from the page cache
+    VCW_Mesh loaded = load_mesh_file(dst_path);
+    std::cout << "loaded " << dst_path << " in " << loaded.load_time << "ms (" << loaded.index_size * 8
+              << " bit indices)" << std::endl;
+}
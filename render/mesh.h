@@ -0,0 +1,116 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#ifndef VCW_MESH_H
+#define VCW_MESH_H
+
+#include "../inc.h"
+#include "../prop.h"
+#include "../util.h"
+
+#include <memory>
+#include <span>
+
+struct Vertex {
+    glm::vec3 pos;
+    glm::vec2 uv;
+};
+
+// a simplified index list over the mesh's vertices, see render/lod.h
+struct VCW_MeshLod {
+    std::vector<uint32_t> indices;
+    float error;
+};
+
+// what App::add_mesh uploads, the spans point into the mesh's own vectors or into a mapped .vcwm file,
+// so a mesh is only moved, never copied
+struct VCW_Mesh {
+    std::span<const Vertex> vertices;
+    // raw indices of index_size bytes each
+    std::span<const char> indices;
+    uint32_t index_size = 2;
+    std::vector<Vertex> vertex_storage;
+    std::vector<char> index_storage;
+    std::shared_ptr<VCW_MappedFile> p_file;
+    // coarser levels after the mesh itself
+    std::vector<VCW_MeshLod> lods;
+    double load_time = 0.0;
+    double lod_time = 0.0;
+
+    VCW_Mesh() = default;
+
+    VCW_Mesh(std::vector<Vertex> mesh_vertices, const std::vector<uint16_t> &mesh_indices);
+
+    // indices are stored with 16 bits if every vertex can be reached with them
+    VCW_Mesh(std::vector<Vertex> mesh_vertices, const std::vector<uint32_t> &mesh_indices);
+
+    VCW_Mesh(const VCW_Mesh &) = delete;
+
+    VCW_Mesh(VCW_Mesh &&) = default;
+
+    VCW_Mesh &operator=(const VCW_Mesh &) = delete;
+
+    VCW_Mesh &operator=(VCW_Mesh &&) = default;
+
+    uint32_t get_index_count() const;
+
+    uint32_t get_index(size_t i) const;
+};
+
+// imported geometry, indices stay 32 bit until the mesh is written
+struct VCW_MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+struct VCW_MeshStats {
+    uint32_t src_vertex_count;
+    double import_time;
+    double optimize_time;
+    // average post transform cache misses per triangle, in the imported order and after optimization
+    float acmr_before;
+    float acmr_after;
+};
+
+// .vcwm files start with this header, the vertices follow and then the indices
+struct VCW_MeshFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertex_size;
+    uint32_t vertex_count;
+    // 2 if every vertex can be reached with 16 bit indices, else 4
+    uint32_t index_size;
+    uint32_t index_count;
+};
+
+VCW_MeshData import_obj(const std::string &path);
+
+VCW_MeshData import_gltf(const std::string &path);
+
+// by extension, .obj, .gltf or .glb
+VCW_MeshData import_mesh(const std::string &path);
+
+void dedup_vertices(VCW_MeshData &mesh);
+
+void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count);
+
+void optimize_overdraw(std::vector<uint32_t> &indices, const std::vector<Vertex> &vertices);
+
+void optimize_vertex_fetch(VCW_MeshData &mesh);
+
+float get_acmr(const std::vector<uint32_t> &indices, size_t vertex_count, uint32_t cache_size);
+
+// dedup, vertex cache, overdraw and vertex fetch order, in that order
+VCW_MeshStats optimize_mesh(VCW_MeshData &mesh);
+
+VCW_Mesh create_mesh(VCW_MeshData &&mesh);
+
+void write_mesh_file(const std::string &path, const VCW_MeshData &mesh);
+
+VCW_Mesh load_mesh_file(const std::string &path);
+
+// imports, optimizes and writes a mesh, timings and cache statistics are printed
+void convert_mesh(const std::string &src_path, const std::string &dst_path);
+
+#endif //VCW_MESH_H
@@ -0,0 +1,107 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "meshlet.h"
+
+#include <cmath>
+
+static void compute_bounds(const VCW_Mesh &mesh, VCW_Meshlet &meshlet) {
+    uint32_t first_index = meshlet.first_triangle * 3;
+    uint32_t last_index = first_index + meshlet.triangle_count * 3;
+
+    glm::vec3 min_pos = mesh.vertices[mesh.get_index(first_index)].pos;
+    glm::vec3 max_pos = min_pos;
+    for (uint32_t i = first_index; i < last_index; i++) {
+        min_pos = glm::min(min_pos, mesh.vertices[mesh.get_index(i)].pos);
+        max_pos = glm::max(max_pos, mesh.vertices[mesh.get_index(i)].pos);
+    }
+    glm::vec3 center = (min_pos + max_pos) / 2.0f;
+    float radius = 0.0f;
+    for (uint32_t i = first_index; i < last_index; i++)
+        radius = std::max(radius, glm::length(mesh.vertices[mesh.get_index(i)].pos - center));
+    meshlet.sphere = glm::vec4(center, radius);
+
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet.triangle_count);
+    glm::vec3 axis(0.0f);
+    for (uint32_t i = first_index; i < last_index; i += 3) {
+        glm::vec3 a = mesh.vertices[mesh.get_index(i)].pos;
+        glm::vec3 n = glm::cross(mesh.vertices[mesh.get_index(i + 1)].pos - a,
+                                 mesh.vertices[mesh.get_index(i + 2)].pos - a);
+        float length = glm::length(n);
+        if (length <= 0.0f)
+            continue;
+        normals.push_back(n / length);
+        axis += normals.back();
+    }
+
+    // the cone has to hold every normal, a wide one never culls and is marked with a cutoff above 1
+    meshlet.cone = glm::vec4(0.0f, 0.0f, 0.0f, 2.0f);
+    float axis_length = glm::length(axis);
+    if (normals.empty() || axis_length <= 0.0f)
+        return;
+    axis /= axis_length;
+
+    float min_dot = 1.0f;
+    for (const auto &n: normals)
+        min_dot = std::min(min_dot, glm::dot(axis, n));
+    if (min_dot <= MESHLET_CONE_MIN_DOT)
+        return;
+    meshlet.cone = glm::vec4(axis, std::sqrt(1.0f - min_dot * min_dot));
+}
+
+std::vector<VCW_Meshlet> build_meshlets(const VCW_Mesh &mesh) {
+    std::vector<VCW_Meshlet> meshlets;
+    // id of the last meshlet that used each vertex, so a vertex is only counted once per meshlet
+    std::vector<uint32_t> used(mesh.vertices.size(), UINT32_MAX);
+
+    VCW_Meshlet meshlet{};
+    uint32_t triangle_count = mesh.get_index_count() / 3;
+    for (uint32_t t = 0; t < triangle_count; t++) {
+        uint32_t tri[3] = {mesh.get_index(t * 3), mesh.get_index(t * 3 + 1), mesh.get_index(t * 3 + 2)};
+        auto id = static_cast<uint32_t>(meshlets.size());
+        uint32_t new_vertices = (used[tri[0]] != id) + (used[tri[1]] != id && tri[1] != tri[0]) +
+                                (used[tri[2]] != id && tri[2] != tri[0] && tri[2] != tri[1]);
+
+        if (meshlet.vertex_count + new_vertices > MESHLET_MAX_VERTICES ||
+            meshlet.triangle_count == MESHLET_MAX_TRIANGLES) {
+            compute_bounds(mesh, meshlet);
+            meshlets.push_back(meshlet);
+            meshlet = {t, 0, 0};
+            id++;
+            new_vertices = 1 + (tri[1] != tri[0]) + (tri[2] != tri[0] && tri[2] != tri[1]);
+        }
+
+        for (uint32_t v: tri)
+            used[v] = id;
+        meshlet.vertex_count += new_vertices;
+        meshlet.triangle_count++;
+    }
+    if (meshlet.triangle_count > 0) {
+        compute_bounds(mesh, meshlet);
+        meshlets.push_back(meshlet);
+    }
+
+    return meshlets;
+}
+
+// the cone test is the bounding sphere variant, conservative for any point of the sphere
+bool is_cluster_culled(glm::vec4 sphere, glm::vec4 cone, const std::array<glm::vec4, 6> &planes, glm::vec3 cam_pos,
+                       VCW_MeshletCullStats *p_stats) {
+    glm::vec3 center(sphere);
+    for (const auto &plane: planes)
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -sphere.w) {
+            if (p_stats)
+                p_stats->frustum_culled++;
+            return true;
+        }
+
+    glm::vec3 view = center - cam_pos;
+    if (glm::dot(view, glm::vec3(cone)) >= cone.w * glm::length(view) + sphere.w) {
+        if (p_stats)
+            p_stats->cone_culled++;
+        return true;
+    }
+    return false;
+}
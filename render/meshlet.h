@@ -0,0 +1,41 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#ifndef VCW_MESHLET_H
+#define VCW_MESHLET_H
+
+#include "../inc.h"
+#include "../prop.h"
+#include "mesh.h"
+
+// a run of the mesh's triangles that shares at most MESHLET_MAX_VERTICES vertices
+struct VCW_Meshlet {
+    uint32_t first_triangle;
+    uint32_t triangle_count;
+    uint32_t vertex_count;
+    // xyz center, w radius
+    glm::vec4 sphere;
+    // xyz axis of the front face normals, w cutoff, above 1 if the normals spread too far to ever cull
+    glm::vec4 cone;
+};
+
+struct VCW_MeshletCullStats {
+    uint32_t meshlet_count = 0;
+    uint32_t frustum_culled = 0;
+    uint32_t cone_culled = 0;
+    uint64_t triangle_count = 0;
+    uint64_t triangles_culled = 0;
+    // triangles facing away from the camera, the share cone culling could reach at best
+    uint64_t back_facing = 0;
+};
+
+// splits the index list in its current order, so a vertex cache optimized mesh gives compact meshlets.
+// front faces are counter clockwise in the mesh's space
+std::vector<VCW_Meshlet> build_meshlets(const VCW_Mesh &mesh);
+
+// sphere and cone in the space of the planes and the camera position
+bool is_cluster_culled(glm::vec4 sphere, glm::vec4 cone, const std::array<glm::vec4, 6> &planes, glm::vec3 cam_pos,
+                       VCW_MeshletCullStats *p_stats = nullptr);
+
+#endif //VCW_MESHLET_H
@@ -0,0 +1,237 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "scene.h"
+#include "camera.h"
+
+#include <random>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define VCW_SCENE_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define VCW_TARGET_AVX
+#else
+#define VCW_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+// a sphere is outside if it lies fully behind one plane, planes point into the frustum
+static uint32_t cull_scalar(const VCW_Scene &scene, const std::array<glm::vec4, 6> &planes, uint8_t *p_visible,
+                            size_t first, size_t last) {
+    uint32_t count = 0;
+    for (size_t i = first; i < last; i++) {
+        bool inside = true;
+        for (const auto &plane: planes)
+            // same association as the simd paths, so all paths round alike
+            inside &= (plane.x * scene.center_x[i] + plane.y * scene.center_y[i]) +
+                      (plane.z * scene.center_z[i] + plane.w) >= -scene.radius[i];
+        p_visible[i] = inside;
+        count += inside;
+    }
+    return count;
+}
+
+#ifdef VCW_SCENE_X86
+// four objects per iteration, sse2 is part of x86-64
+static uint32_t cull_sse(const VCW_Scene &scene, const std::array<glm::vec4, 6> &planes, uint8_t *p_visible,
+                         size_t first, size_t last) {
+    uint32_t count = 0;
+    size_t i = first;
+    for (; i + 4 <= last; i += 4) {
+        __m128 x = _mm_loadu_ps(&scene.center_x[i]);
+        __m128 y = _mm_loadu_ps(&scene.center_y[i]);
+        __m128 z = _mm_loadu_ps(&scene.center_z[i]);
+        __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&scene.radius[i]));
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const auto &plane: planes) {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)),
+                                                _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+                                     _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, neg_r));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (int lane = 0; lane < 4; lane++)
+            p_visible[i + lane] = (mask >> lane) & 1;
+        count += std::popcount(static_cast<uint32_t>(mask));
+    }
+    return count + cull_scalar(scene, planes, p_visible, i, last);
+}
+
+static VCW_TARGET_AVX uint32_t cull_avx(const VCW_Scene &scene, const std::array<glm::vec4, 6> &planes,
+                                        uint8_t *p_visible, size_t first, size_t last) {
+    uint32_t count = 0;
+    size_t i = first;
+    for (; i + 8 <= last; i += 8) {
+        __m256 x = _mm256_loadu_ps(&scene.center_x[i]);
+        __m256 y = _mm256_loadu_ps(&scene.center_y[i]);
+        __m256 z = _mm256_loadu_ps(&scene.center_z[i]);
+        __m256 neg_r = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&scene.radius[i]));
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const auto &plane: planes) {
+            __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(plane.x)),
+                                                      _mm256_mul_ps(y, _mm256_set1_ps(plane.y))),
+                                        _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(plane.z)),
+                                                      _mm256_set1_ps(plane.w)));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, neg_r, _CMP_GE_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(inside);
+        for (int lane = 0; lane < 8; lane++)
+            p_visible[i + lane] = (mask >> lane) & 1;
+        count += std::popcount(static_cast<uint32_t>(mask));
+    }
+    return count + cull_scalar(scene, planes, p_visible, i, last);
+}
+#endif
+
+VCW_CullPath get_best_cull_path() {
+#ifdef VCW_SCENE_X86
+#ifdef _MSC_VER
+    // the cpu has to support avx and the os has to save the ymm registers
+    int info[4];
+    __cpuid(info, 1);
+    bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+#else
+    bool avx = __builtin_cpu_supports("avx");
+#endif
+    return avx ? CULL_AVX : CULL_SSE;
+#else
+    return CULL_SCALAR;
+#endif
+}
+
+const char *get_cull_path_name(VCW_CullPath path) {
+    switch (path) {
+        case CULL_SSE:
+            return "sse";
+        case CULL_AVX:
+            return "avx";
+        default:
+            return "scalar";
+    }
+}
+
+VCW_Scene::VCW_Scene() {
+    path = get_best_cull_path();
+}
+
+uint32_t VCW_Scene::add_object(glm::vec3 center, float object_radius, uint32_t mesh_index) {
+    center_x.push_back(center.x);
+    center_y.push_back(center.y);
+    center_z.push_back(center.z);
+    radius.push_back(object_radius);
+    visible.push_back(1);
+    visible_count++;
+    mesh.push_back(mesh_index);
+    lod.push_back(0);
+    return static_cast<uint32_t>(radius.size() - 1);
+}
+
+void VCW_Scene::clear() {
+    center_x.clear();
+    center_y.clear();
+    center_z.clear();
+    radius.clear();
+    visible.clear();
+    visible_count = 0;
+    mesh.clear();
+    lod.clear();
+}
+
+size_t VCW_Scene::size() const {
+    return radius.size();
+}
+
+uint32_t VCW_Scene::cull_range(const std::array<glm::vec4, 6> &planes, size_t first, size_t last,
+                               VCW_CullPath range_path) {
+    switch (range_path) {
+#ifdef VCW_SCENE_X86
+        case CULL_SSE:
+            return cull_sse(*this, planes, visible.data(), first, last);
+        case CULL_AVX:
+            return cull_avx(*this, planes, visible.data(), first, last);
+#endif
+        default:
+            return cull_scalar(*this, planes, visible.data(), first, last);
+    }
+}
+
+// chunks are multiples of the simd width, only the last one has a scalar tail
+uint32_t VCW_Scene::cull(const std::array<glm::vec4, 6> &planes, VCW_ThreadPool *p_pool) {
+    size_t count = size();
+    if (!p_pool || p_pool->size() == 0 || count < SCENE_CULL_PARALLEL_MIN) {
+        visible_count = cull_range(planes, 0, count, path);
+        return visible_count;
+    }
+
+    uint32_t chunk_count = static_cast<uint32_t>((count + SCENE_CULL_CHUNK - 1) / SCENE_CULL_CHUNK);
+    std::vector<uint32_t> chunk_visible(chunk_count);
+    p_pool->parallel_for(chunk_count, [&](uint32_t chunk) {
+        size_t first = static_cast<size_t>(chunk) * SCENE_CULL_CHUNK;
+        chunk_visible[chunk] = cull_range(planes, first, std::min(count, first + SCENE_CULL_CHUNK), path);
+    });
+
+    visible_count = 0;
+    for (uint32_t n: chunk_visible)
+        visible_count += n;
+    return visible_count;
+}
+
+// random spheres around the default camera, every path has to agree on the result
+void bench_scene_cull(VCW_ThreadPool &pool) {
+    VCW_Camera cam{};
+    cam.create_default_cam({1920, 1080});
+    cam.update_cam_rotation(0.0f, 0.0f);
+    std::array<glm::vec4, 6> planes = cam.get_frustum_planes();
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> pos_dist(-SCENE_BENCH_EXTENT, SCENE_BENCH_EXTENT);
+    std::uniform_real_distribution<float> radius_dist(0.5f, 2.0f);
+
+    std::vector<VCW_CullPath> paths = {CULL_SCALAR};
+#ifdef VCW_SCENE_X86
+    paths.push_back(CULL_SSE);
+    if (get_best_cull_path() == CULL_AVX)
+        paths.push_back(CULL_AVX);
+#endif
+
+    for (size_t count: {10000, 100000, 1000000}) {
+        VCW_Scene scene;
+        for (size_t i = 0; i < count; i++)
+            scene.add_object({pos_dist(rng), pos_dist(rng), pos_dist(rng)}, radius_dist(rng));
+
+        // roughly the same amount of work for every scene size
+        uint32_t iterations = static_cast<uint32_t>(std::max<size_t>(1, SCENE_BENCH_OBJECTS / count));
+        auto objects_per_sec = [&](const std::function<uint32_t()> &cull) {
+            cull();
+            auto start_time = std::chrono::high_resolution_clock::now();
+            for (uint32_t i = 0; i < iterations; i++)
+                cull();
+            auto end_time = std::chrono::high_resolution_clock::now();
+            return static_cast<double>(count) * iterations /
+                   std::chrono::duration<double>(end_time - start_time).count();
+        };
+
+        uint32_t expected = scene.cull_range(planes, 0, count, CULL_SCALAR);
+        std::cout << "cull " << count << " objects (" << expected << " visible):";
+        for (VCW_CullPath cull_path: paths) {
+            if (scene.cull_range(planes, 0, count, cull_path) != expected)
+                throw std::runtime_error("cull paths disagree.");
+
+            double rate = objects_per_sec([&]() { return scene.cull_range(planes, 0, count, cull_path); });
+            std::cout << " " << get_cull_path_name(cull_path) << " " << rate / 1e6 << "M/s";
+        }
+
+        if (scene.cull(planes, &pool) != expected)
+            throw std::runtime_error("cull paths disagree.");
+        double rate = objects_per_sec([&]() { return scene.cull(planes, &pool); });
+        std::cout << ", " << get_cull_path_name(scene.path) << " on " << pool.size() + 1 << " threads "
+                  << rate / 1e6 << "M/s" << std::endl;
+    }
+}
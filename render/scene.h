@@ -0,0 +1,58 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#ifndef VCW_SCENE_H
+#define VCW_SCENE_H
+
+#include "../inc.h"
+#include "../prop.h"
+#include "../thread_pool.h"
+
+enum VCW_CullPath {
+    CULL_SCALAR,
+    CULL_SSE,
+    CULL_AVX
+};
+
+// objects as structure of arrays, culling streams through the bounds and nothing else
+class VCW_Scene {
+public:
+    // bounding spheres
+    std::vector<float> center_x;
+    std::vector<float> center_y;
+    std::vector<float> center_z;
+    std::vector<float> radius;
+
+    // result of the last cull, 1 if the object's sphere intersects the frustum
+    std::vector<uint8_t> visible;
+    uint32_t visible_count = 0;
+
+    // geometry store range and its detail level picked for the last frame
+    std::vector<uint32_t> mesh;
+    std::vector<uint8_t> lod;
+
+    // widest path the cpu supports, set on construction
+    VCW_CullPath path;
+
+    VCW_Scene();
+
+    uint32_t add_object(glm::vec3 center, float object_radius, uint32_t mesh_index = 0);
+
+    void clear();
+
+    size_t size() const;
+
+    // planes as returned by VCW_Camera::get_frustum_planes, large scenes are split over the pool's threads
+    uint32_t cull(const std::array<glm::vec4, 6> &planes, VCW_ThreadPool *p_pool = nullptr);
+
+    uint32_t cull_range(const std::array<glm::vec4, 6> &planes, size_t first, size_t last, VCW_CullPath range_path);
+};
+
+VCW_CullPath get_best_cull_path();
+
+const char *get_cull_path_name(VCW_CullPath path);
+
+void bench_scene_cull(VCW_ThreadPool &pool);
+
+#endif //VCW_SCENE_H
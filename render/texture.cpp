@@ -0,0 +1,514 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "texture.h"
+#include "../util.h"
+
+struct VCW_FormatBlock {
+    VkFormat format;
+    uint32_t bytes;
+    uint32_t width;
+    uint32_t height;
+};
+
+const VCW_FormatBlock FORMAT_BLOCKS[] = {
+        {VK_FORMAT_R8G8B8A8_UNORM,           4,  1, 1},
+        {VK_FORMAT_R8G8B8A8_SRGB,            4,  1, 1},
+        {VK_FORMAT_B8G8R8A8_UNORM,           4,  1, 1},
+        {VK_FORMAT_B8G8R8A8_SRGB,            4,  1, 1},
+        {VK_FORMAT_BC1_RGB_UNORM_BLOCK,      8,  4, 4},
+        {VK_FORMAT_BC1_RGB_SRGB_BLOCK,       8,  4, 4},
+        {VK_FORMAT_BC1_RGBA_UNORM_BLOCK,     8,  4, 4},
+        {VK_FORMAT_BC1_RGBA_SRGB_BLOCK,      8,  4, 4},
+        {VK_FORMAT_BC2_UNORM_BLOCK,          16, 4, 4},
+        {VK_FORMAT_BC2_SRGB_BLOCK,           16, 4, 4},
+        {VK_FORMAT_BC3_UNORM_BLOCK,          16, 4, 4},
+        {VK_FORMAT_BC3_SRGB_BLOCK,           16, 4, 4},
+        {VK_FORMAT_BC4_UNORM_BLOCK,          8,  4, 4},
+        {VK_FORMAT_BC4_SNORM_BLOCK,          8,  4, 4},
+        {VK_FORMAT_BC5_UNORM_BLOCK,          16, 4, 4},
+        {VK_FORMAT_BC5_SNORM_BLOCK,          16, 4, 4},
+        {VK_FORMAT_BC6H_UFLOAT_BLOCK,        16, 4, 4},
+        {VK_FORMAT_BC6H_SFLOAT_BLOCK,        16, 4, 4},
+        {VK_FORMAT_BC7_UNORM_BLOCK,          16, 4, 4},
+        {VK_FORMAT_BC7_SRGB_BLOCK,           16, 4, 4},
+        {VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK,   8,  4, 4},
+        {VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK,    8,  4, 4},
+        {VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, 8,  4, 4},
+        {VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK,  8,  4, 4},
+        {VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, 16, 4, 4},
+        {VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK,  16, 4, 4},
+        {VK_FORMAT_ASTC_4x4_UNORM_BLOCK,     16, 4, 4},
+        {VK_FORMAT_ASTC_4x4_SRGB_BLOCK,      16, 4, 4},
+        {VK_FORMAT_ASTC_5x5_UNORM_BLOCK,     16, 5, 5},
+        {VK_FORMAT_ASTC_5x5_SRGB_BLOCK,      16, 5, 5},
+        {VK_FORMAT_ASTC_6x6_UNORM_BLOCK,     16, 6, 6},
+        {VK_FORMAT_ASTC_6x6_SRGB_BLOCK,      16, 6, 6},
+        {VK_FORMAT_ASTC_8x8_UNORM_BLOCK,     16, 8, 8},
+        {VK_FORMAT_ASTC_8x8_SRGB_BLOCK,      16, 8, 8},
+};
+
+bool get_format_block(VkFormat format, uint32_t &block_bytes, uint32_t &block_width, uint32_t &block_height) {
+    for (const auto &block: FORMAT_BLOCKS) {
+        if (block.format == format) {
+            block_bytes = block.bytes;
+            block_width = block.width;
+            block_height = block.height;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+VkDeviceSize get_level_size(VkFormat format, uint32_t width, uint32_t height, uint32_t level, uint32_t layers) {
+    uint32_t block_bytes, block_width, block_height;
+    if (!get_format_block(format, block_bytes, block_width, block_height))
+        throw std::runtime_error("unsupported texture format.");
+
+    VkDeviceSize blocks_x = (std::max(width >> level, 1u) + block_width - 1) / block_width;
+    VkDeviceSize blocks_y = (std::max(height >> level, 1u) + block_height - 1) / block_height;
+
+    return blocks_x * blocks_y * block_bytes * layers;
+}
+
+// container fields are little endian
+template<typename T>
+T read_val(const std::vector<char> &data, size_t offset) {
+    if (offset + sizeof(T) > data.size())
+        throw std::runtime_error("texture file is truncated.");
+
+    T val;
+    memcpy(&val, data.data() + offset, sizeof(T));
+    return val;
+}
+
+uint32_t four_cc(const char *code) {
+    return static_cast<uint32_t>(code[0]) | static_cast<uint32_t>(code[1]) << 8 |
+           static_cast<uint32_t>(code[2]) << 16 | static_cast<uint32_t>(code[3]) << 24;
+}
+
+VCW_ImageData load_ktx2(const std::string &path) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::vector<char> data = read_file(path);
+
+    const unsigned char ktx2_id[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+    if (data.size() < 80 || memcmp(data.data(), ktx2_id, sizeof(ktx2_id)) != 0)
+        throw std::runtime_error("not a ktx2 file.");
+
+    VCW_ImageData img_data;
+    img_data.format = static_cast<VkFormat>(read_val<uint32_t>(data, 12));
+    img_data.width = read_val<uint32_t>(data, 20);
+    img_data.height = read_val<uint32_t>(data, 24);
+    uint32_t depth = read_val<uint32_t>(data, 28);
+    uint32_t layers = read_val<uint32_t>(data, 32);
+    uint32_t faces = read_val<uint32_t>(data, 36);
+    uint32_t levels = read_val<uint32_t>(data, 40);
+    uint32_t supercompression = read_val<uint32_t>(data, 44);
+
+    if (img_data.format == VK_FORMAT_UNDEFINED || supercompression != 0)
+        throw std::runtime_error("basis universal and supercompressed ktx2 files are not supported.");
+    if (depth > 1 || faces != 1)
+        throw std::runtime_error("only 2d ktx2 textures are supported.");
+
+    // a level count of 0 asks for the chain to be generated
+    img_data.mip_levels = std::max(levels, 1u);
+    img_data.array_layers = std::max(layers, 1u);
+
+    // the level index follows the 80 byte header, levels are stored smallest first but indexed from the base
+    for (uint32_t level = 0; level < img_data.mip_levels; level++) {
+        auto offset = read_val<uint64_t>(data, 80 + level * 24);
+        auto length = read_val<uint64_t>(data, 80 + level * 24 + 8);
+
+        VkDeviceSize level_size = get_level_size(img_data.format, img_data.width, img_data.height, level,
+                                                 img_data.array_layers);
+        if (length != level_size || offset + length > data.size())
+            throw std::runtime_error("ktx2 level does not match its format.");
+
+        img_data.pixels.insert(img_data.pixels.end(), data.begin() + static_cast<std::ptrdiff_t>(offset),
+                               data.begin() + static_cast<std::ptrdiff_t>(offset + length));
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    img_data.load_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+
+    return img_data;
+}
+
+VkFormat get_dxgi_format(uint32_t dxgi_format) {
+    switch (dxgi_format) {
+        case 28:
+            return VK_FORMAT_R8G8B8A8_UNORM;
+        case 29:
+            return VK_FORMAT_R8G8B8A8_SRGB;
+        case 87:
+            return VK_FORMAT_B8G8R8A8_UNORM;
+        case 91:
+            return VK_FORMAT_B8G8R8A8_SRGB;
+        case 71:
+            return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case 72:
+            return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        case 74:
+            return VK_FORMAT_BC2_UNORM_BLOCK;
+        case 75:
+            return VK_FORMAT_BC2_SRGB_BLOCK;
+        case 77:
+            return VK_FORMAT_BC3_UNORM_BLOCK;
+        case 78:
+            return VK_FORMAT_BC3_SRGB_BLOCK;
+        case 80:
+            return VK_FORMAT_BC4_UNORM_BLOCK;
+        case 81:
+            return VK_FORMAT_BC4_SNORM_BLOCK;
+        case 83:
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        case 84:
+            return VK_FORMAT_BC5_SNORM_BLOCK;
+        case 95:
+            return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+        case 96:
+            return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+        case 98:
+            return VK_FORMAT_BC7_UNORM_BLOCK;
+        case 99:
+            return VK_FORMAT_BC7_SRGB_BLOCK;
+        default:
+            return VK_FORMAT_UNDEFINED;
+    }
+}
+
+VCW_ImageData load_dds(const std::string &path) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::vector<char> data = read_file(path);
+
+    if (data.size() < 128 || memcmp(data.data(), "DDS ", 4) != 0)
+        throw std::runtime_error("not a dds file.");
+
+    VCW_ImageData img_data;
+    img_data.height = read_val<uint32_t>(data, 12);
+    img_data.width = read_val<uint32_t>(data, 16);
+    img_data.mip_levels = std::max(read_val<uint32_t>(data, 28), 1u);
+
+    uint32_t pf_flags = read_val<uint32_t>(data, 80);
+    uint32_t pf_four_cc = read_val<uint32_t>(data, 84);
+    uint32_t pf_bit_count = read_val<uint32_t>(data, 88);
+    uint32_t pf_r_mask = read_val<uint32_t>(data, 92);
+    uint32_t caps2 = read_val<uint32_t>(data, 112);
+
+    const uint32_t DDPF_FOURCC = 0x4;
+    const uint32_t DDPF_RGB = 0x40;
+    const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+
+    if (caps2 & DDSCAPS2_CUBEMAP)
+        throw std::runtime_error("only 2d dds textures are supported.");
+
+    size_t data_offset = 128;
+    img_data.format = VK_FORMAT_UNDEFINED;
+
+    if ((pf_flags & DDPF_FOURCC) && pf_four_cc == four_cc("DX10")) {
+        uint32_t dxgi_format = read_val<uint32_t>(data, 128);
+        uint32_t dimension = read_val<uint32_t>(data, 132);
+        uint32_t misc_flags = read_val<uint32_t>(data, 136);
+        img_data.array_layers = std::max(read_val<uint32_t>(data, 140), 1u);
+        data_offset += 20;
+
+        // 3 is DDS_DIMENSION_TEXTURE2D, 0x4 marks cube maps
+        if (dimension != 3 || (misc_flags & 0x4))
+            throw std::runtime_error("only 2d dds textures are supported.");
+
+        img_data.format = get_dxgi_format(dxgi_format);
+    } else if (pf_flags & DDPF_FOURCC) {
+        if (pf_four_cc == four_cc("DXT1"))
+            img_data.format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        else if (pf_four_cc == four_cc("DXT2") || pf_four_cc == four_cc("DXT3"))
+            img_data.format = VK_FORMAT_BC2_UNORM_BLOCK;
+        else if (pf_four_cc == four_cc("DXT4") || pf_four_cc == four_cc("DXT5"))
+            img_data.format = VK_FORMAT_BC3_UNORM_BLOCK;
+        else if (pf_four_cc == four_cc("ATI1") || pf_four_cc == four_cc("BC4U"))
+            img_data.format = VK_FORMAT_BC4_UNORM_BLOCK;
+        else if (pf_four_cc == four_cc("BC4S"))
+            img_data.format = VK_FORMAT_BC4_SNORM_BLOCK;
+        else if (pf_four_cc == four_cc("ATI2") || pf_four_cc == four_cc("BC5U"))
+            img_data.format = VK_FORMAT_BC5_UNORM_BLOCK;
+        else if (pf_four_cc == four_cc("BC5S"))
+            img_data.format = VK_FORMAT_BC5_SNORM_BLOCK;
+    } else if ((pf_flags & DDPF_RGB) && pf_bit_count == 32) {
+        if (pf_r_mask == 0x000000ff)
+            img_data.format = VK_FORMAT_R8G8B8A8_UNORM;
+        else if (pf_r_mask == 0x00ff0000)
+            img_data.format = VK_FORMAT_B8G8R8A8_UNORM;
+    }
+
+    if (img_data.format == VK_FORMAT_UNDEFINED)
+        throw std::runtime_error("unsupported dds format.");
+
+    // dds stores every level of a layer before the next layer, uploads want the layers of a level together
+    std::vector<VkDeviceSize> level_offsets(img_data.mip_levels);
+    VkDeviceSize layer_size = 0;
+    for (uint32_t level = 0; level < img_data.mip_levels; level++) {
+        level_offsets[level] = layer_size;
+        layer_size += get_level_size(img_data.format, img_data.width, img_data.height, level, 1);
+    }
+
+    if (data_offset + layer_size * img_data.array_layers > data.size())
+        throw std::runtime_error("texture file is truncated.");
+
+    img_data.pixels.reserve(layer_size * img_data.array_layers);
+    for (uint32_t level = 0; level < img_data.mip_levels; level++) {
+        VkDeviceSize level_size = get_level_size(img_data.format, img_data.width, img_data.height, level, 1);
+
+        for (uint32_t layer = 0; layer < img_data.array_layers; layer++) {
+            auto src = data.begin() + static_cast<std::ptrdiff_t>(data_offset + layer * layer_size +
+                                                                  level_offsets[level]);
+            img_data.pixels.insert(img_data.pixels.end(), src, src + static_cast<std::ptrdiff_t>(level_size));
+        }
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    img_data.load_time = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+
+    return img_data;
+}
+
+//
+// cpu decoding of the simple block formats, for devices without bc support
+//
+VkFormat get_decoded_format(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            return VK_FORMAT_R8G8B8A8_UNORM;
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+            return VK_FORMAT_R8G8B8A8_SRGB;
+        default:
+            return VK_FORMAT_UNDEFINED;
+    }
+}
+
+VkFormat get_linear_format(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            return VK_FORMAT_R8G8B8A8_UNORM;
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            return VK_FORMAT_B8G8R8A8_UNORM;
+        default:
+            return format;
+    }
+}
+
+void expand_565(uint16_t color, unsigned char *p_rgba) {
+    uint32_t r = (color >> 11) & 0x1f;
+    uint32_t g = (color >> 5) & 0x3f;
+    uint32_t b = color & 0x1f;
+
+    p_rgba[0] = static_cast<unsigned char>((r << 3) | (r >> 2));
+    p_rgba[1] = static_cast<unsigned char>((g << 2) | (g >> 4));
+    p_rgba[2] = static_cast<unsigned char>((b << 3) | (b >> 2));
+    p_rgba[3] = 255;
+}
+
+// bc1 layout, bc2 and bc3 always use the four color mode
+void decode_color_block(const unsigned char *p_block, unsigned char texels[16][4], bool four_color) {
+    uint16_t c0 = static_cast<uint16_t>(p_block[0] | p_block[1] << 8);
+    uint16_t c1 = static_cast<uint16_t>(p_block[2] | p_block[3] << 8);
+
+    unsigned char palette[4][4];
+    expand_565(c0, palette[0]);
+    expand_565(c1, palette[1]);
+
+    if (four_color || c0 > c1) {
+        for (int ch = 0; ch < 3; ch++) {
+            palette[2][ch] = static_cast<unsigned char>((2 * palette[0][ch] + palette[1][ch]) / 3);
+            palette[3][ch] = static_cast<unsigned char>((palette[0][ch] + 2 * palette[1][ch]) / 3);
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 255;
+    } else {
+        for (int ch = 0; ch < 3; ch++)
+            palette[2][ch] = static_cast<unsigned char>((palette[0][ch] + palette[1][ch]) / 2);
+        palette[2][3] = 255;
+        memset(palette[3], 0, 4);
+    }
+
+    uint32_t indices = p_block[4] | p_block[5] << 8 | p_block[6] << 16 | static_cast<uint32_t>(p_block[7]) << 24;
+    for (int i = 0; i < 16; i++)
+        memcpy(texels[i], palette[(indices >> (2 * i)) & 3], 4);
+}
+
+// bc3 alpha, bc4 and bc5 channels
+void decode_channel_block(const unsigned char *p_block, unsigned char values[16]) {
+    unsigned char palette[8];
+    palette[0] = p_block[0];
+    palette[1] = p_block[1];
+
+    if (palette[0] > palette[1]) {
+        for (int i = 1; i <= 6; i++)
+            palette[i + 1] = static_cast<unsigned char>(((7 - i) * palette[0] + i * palette[1]) / 7);
+    } else {
+        for (int i = 1; i <= 4; i++)
+            palette[i + 1] = static_cast<unsigned char>(((5 - i) * palette[0] + i * palette[1]) / 5);
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; i++)
+        indices |= static_cast<uint64_t>(p_block[2 + i]) << (8 * i);
+
+    for (int i = 0; i < 16; i++)
+        values[i] = palette[(indices >> (3 * i)) & 7];
+}
+
+void decode_block(VkFormat format, const unsigned char *p_block, unsigned char texels[16][4]) {
+    unsigned char channel[16];
+
+    switch (format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            decode_color_block(p_block, texels, false);
+            for (int i = 0; i < 16; i++)
+                texels[i][3] = 255;
+            break;
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            decode_color_block(p_block, texels, false);
+            break;
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+            decode_color_block(p_block + 8, texels, true);
+            for (int i = 0; i < 16; i++)
+                texels[i][3] = static_cast<unsigned char>(((p_block[i / 2] >> ((i % 2) * 4)) & 0xf) * 17);
+            break;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+            decode_color_block(p_block + 8, texels, true);
+            decode_channel_block(p_block, channel);
+            for (int i = 0; i < 16; i++)
+                texels[i][3] = channel[i];
+            break;
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+            decode_channel_block(p_block, channel);
+            for (int i = 0; i < 16; i++) {
+                texels[i][0] = channel[i];
+                texels[i][1] = 0;
+                texels[i][2] = 0;
+                texels[i][3] = 255;
+            }
+            break;
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            decode_channel_block(p_block, channel);
+            for (int i = 0; i < 16; i++) {
+                texels[i][0] = channel[i];
+                texels[i][2] = 0;
+                texels[i][3] = 255;
+            }
+            decode_channel_block(p_block + 8, channel);
+            for (int i = 0; i < 16; i++)
+                texels[i][1] = channel[i];
+            break;
+        default:
+            throw std::runtime_error("no cpu decoder for texture format.");
+    }
+}
+
+// every stored level is decoded, the image keeps its mip chain
+void decode_bc(VCW_ImageData &img_data) {
+    VkFormat decoded_format = get_decoded_format(img_data.format);
+    if (decoded_format == VK_FORMAT_UNDEFINED)
+        throw std::runtime_error("no cpu decoder for texture format.");
+
+    uint32_t block_bytes, block_width, block_height;
+    get_format_block(img_data.format, block_bytes, block_width, block_height);
+
+    std::vector<unsigned char> decoded;
+    size_t src_offset = 0;
+
+    for (uint32_t level = 0; level < img_data.mip_levels; level++) {
+        uint32_t width = std::max(img_data.width >> level, 1u);
+        uint32_t height = std::max(img_data.height >> level, 1u);
+        uint32_t blocks_x = (width + 3) / 4;
+        uint32_t blocks_y = (height + 3) / 4;
+
+        for (uint32_t layer = 0; layer < img_data.array_layers; layer++) {
+            size_t dst_base = decoded.size();
+            decoded.resize(dst_base + static_cast<size_t>(width) * height * 4);
+
+            for (uint32_t by = 0; by < blocks_y; by++) {
+                for (uint32_t bx = 0; bx < blocks_x; bx++) {
+                    unsigned char texels[16][4];
+                    decode_block(img_data.format, &img_data.pixels[src_offset], texels);
+                    src_offset += block_bytes;
+
+                    // edge blocks hang over the level
+                    for (uint32_t ty = 0; ty < 4; ty++) {
+                        for (uint32_t tx = 0; tx < 4; tx++) {
+                            uint32_t x = bx * 4 + tx;
+                            uint32_t y = by * 4 + ty;
+                            if (x < width && y < height)
+                                memcpy(&decoded[dst_base + (static_cast<size_t>(y) * width + x) * 4],
+                                       texels[ty * 4 + tx], 4);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    img_data.format = decoded_format;
+    img_data.pixels = std::move(decoded);
+}
+
+// box filtered chain for uncompressed 8 bit data with only the base level stored,
+// srgb data is averaged without linearizing, which slightly darkens the coarse levels
+void build_mip_chain(VCW_ImageData &img_data) {
+    uint32_t block_bytes, block_width, block_height;
+    if (img_data.mip_levels != 1 || !get_format_block(img_data.format, block_bytes, block_width, block_height) ||
+        block_width != 1)
+        return;
+
+    img_data.mip_levels = static_cast<uint32_t>(std::bit_width(std::max(img_data.width, img_data.height)));
+
+    size_t src_offset = 0;
+    for (uint32_t level = 1; level < img_data.mip_levels; level++) {
+        uint32_t src_width = std::max(img_data.width >> (level - 1), 1u);
+        uint32_t src_height = std::max(img_data.height >> (level - 1), 1u);
+        uint32_t width = std::max(img_data.width >> level, 1u);
+        uint32_t height = std::max(img_data.height >> level, 1u);
+
+        size_t src_layer_size = static_cast<size_t>(src_width) * src_height * 4;
+        size_t dst_offset = img_data.pixels.size();
+        img_data.pixels.resize(dst_offset + static_cast<size_t>(width) * height * 4 * img_data.array_layers);
+
+        for (uint32_t layer = 0; layer < img_data.array_layers; layer++) {
+            const unsigned char *p_src = &img_data.pixels[src_offset + layer * src_layer_size];
+            unsigned char *p_dst = &img_data.pixels[dst_offset + static_cast<size_t>(layer) * width * height * 4];
+
+            for (uint32_t y = 0; y < height; y++) {
+                uint32_t y0 = std::min(y * 2, src_height - 1);
+                uint32_t y1 = std::min(y * 2 + 1, src_height - 1);
+
+                for (uint32_t x = 0; x < width; x++) {
+                    uint32_t x0 = std::min(x * 2, src_width - 1);
+                    uint32_t x1 = std::min(x * 2 + 1, src_width - 1);
+
+                    for (uint32_t ch = 0; ch < 4; ch++) {
+                        uint32_t sum = p_src[(y0 * src_width + x0) * 4 + ch] + p_src[(y0 * src_width + x1) * 4 + ch] +
+                                       p_src[(y1 * src_width + x0) * 4 + ch] + p_src[(y1 * src_width + x1) * 4 + ch];
+                        p_dst[(y * width + x) * 4 + ch] = static_cast<unsigned char>((sum + 2) / 4);
+                    }
+                }
+            }
+        }
+
+        src_offset += src_layer_size * img_data.array_layers;
+    }
+}
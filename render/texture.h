@@ -0,0 +1,39 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#ifndef VCW_TEXTURE_H
+#define VCW_TEXTURE_H
+
+#include "../inc.h"
+
+// pixels of all stored levels, level after level with the layers of a level tightly packed
+struct VCW_ImageData {
+    VkFormat format;
+    uint32_t width;
+    uint32_t height;
+    // 1 if only the base level is stored, the rest of the chain is then generated on the gpu
+    uint32_t mip_levels = 1;
+    uint32_t array_layers = 1;
+    std::vector<unsigned char> pixels;
+    double load_time = 0.0;
+};
+
+bool get_format_block(VkFormat format, uint32_t &block_bytes, uint32_t &block_width, uint32_t &block_height);
+
+VkDeviceSize get_level_size(VkFormat format, uint32_t width, uint32_t height, uint32_t level, uint32_t layers);
+
+VCW_ImageData load_ktx2(const std::string &path);
+
+VCW_ImageData load_dds(const std::string &path);
+
+VkFormat get_decoded_format(VkFormat format);
+
+// the unorm format of the same bits for srgb formats, the format itself otherwise
+VkFormat get_linear_format(VkFormat format);
+
+void decode_bc(VCW_ImageData &img_data);
+
+void build_mip_chain(VCW_ImageData &img_data);
+
+#endif //VCW_TEXTURE_H
@@ -0,0 +1,135 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "vertex_layout.h"
+
+#include <cmath>
+
+// rounds to nearest even, small values become subnormals, large ones infinity
+uint16_t float_to_half(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    int32_t exp = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mant = bits & 0x7fffff;
+
+    if ((bits & 0x7fffffff) > 0x7f800000)
+        return sign | 0x7e00;
+    if (exp >= 31)
+        return sign | 0x7c00;
+
+    if (exp <= 0) {
+        if (exp < -10)
+            return sign;
+        mant |= 0x800000;
+        uint32_t shift = 14 - exp;
+        uint32_t half = mant >> shift;
+        uint32_t rest = mant & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+            half++;
+        return sign | static_cast<uint16_t>(half);
+    }
+
+    // a carry out of the mantissa correctly bumps the exponent
+    uint32_t half = (static_cast<uint32_t>(exp) << 10) | (mant >> 13);
+    uint32_t rest = mant & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        half++;
+    return sign | static_cast<uint16_t>(half);
+}
+
+int16_t float_to_snorm16(float value) {
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+// the lower hemisphere is folded over the diagonals, decode_oct in shader.vert reverses it
+glm::vec2 encode_oct(glm::vec3 normal) {
+    normal /= std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    glm::vec2 oct(normal.x, normal.y);
+    if (normal.z < 0.0f)
+        oct = glm::vec2((1.0f - std::abs(normal.y)) * (normal.x >= 0.0f ? 1.0f : -1.0f),
+                        (1.0f - std::abs(normal.x)) * (normal.y >= 0.0f ? 1.0f : -1.0f));
+    return oct;
+}
+
+// center and half extent of the bounding box, flat axes keep a tiny extent so nothing divides by zero
+VCW_PosDequant get_pos_dequant(std::span<const Vertex> vertices) {
+    if (vertices.empty())
+        return {glm::vec4(0.0f), glm::vec4(1.0f)};
+
+    glm::vec3 min_pos = vertices[0].pos;
+    glm::vec3 max_pos = vertices[0].pos;
+    for (const auto &vertex: vertices) {
+        min_pos = glm::min(min_pos, vertex.pos);
+        max_pos = glm::max(max_pos, vertex.pos);
+    }
+    glm::vec3 extent = glm::max((max_pos - min_pos) / 2.0f, glm::vec3(1e-6f));
+    return {glm::vec4((min_pos + max_pos) / 2.0f, 0.0f), glm::vec4(extent, 1.0f)};
+}
+
+std::vector<glm::vec3> generate_normals(const VCW_Mesh &mesh) {
+    std::vector<glm::vec3> normals(mesh.vertices.size(), glm::vec3(0.0f));
+    uint32_t index_count = mesh.get_index_count();
+    for (uint32_t i = 0; i + 2 < index_count; i += 3) {
+        uint32_t a = mesh.get_index(i);
+        uint32_t b = mesh.get_index(i + 1);
+        uint32_t c = mesh.get_index(i + 2);
+        // the cross product's length is twice the triangle's area
+        glm::vec3 face = glm::cross(mesh.vertices[b].pos - mesh.vertices[a].pos,
+                                    mesh.vertices[c].pos - mesh.vertices[a].pos);
+        normals[a] += face;
+        normals[b] += face;
+        normals[c] += face;
+    }
+
+    for (auto &normal: normals) {
+        float length = glm::length(normal);
+        normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+    return normals;
+}
+
+static void pack_pos(int16_t *p_dst, glm::vec3 pos, const VCW_PosDequant &dequant) {
+    glm::vec3 unit = (pos - glm::vec3(dequant.offset)) / glm::vec3(dequant.scale);
+    p_dst[0] = float_to_snorm16(unit.x);
+    p_dst[1] = float_to_snorm16(unit.y);
+    p_dst[2] = float_to_snorm16(unit.z);
+    p_dst[3] = 0;
+}
+
+static void pack_attribs(uint16_t *p_uv, int16_t *p_normal, const Vertex &vertex, glm::vec3 normal) {
+    p_uv[0] = float_to_half(vertex.uv.x);
+    p_uv[1] = float_to_half(vertex.uv.y);
+    glm::vec2 oct = encode_oct(normal);
+    p_normal[0] = float_to_snorm16(oct.x);
+    p_normal[1] = float_to_snorm16(oct.y);
+}
+
+VCW_PosFloat VCW_PosFloat::pack(const Vertex &vertex, glm::vec3, const VCW_PosDequant &) {
+    return {vertex.pos};
+}
+
+VCW_PosSnorm16 VCW_PosSnorm16::pack(const Vertex &vertex, glm::vec3, const VCW_PosDequant &dequant) {
+    VCW_PosSnorm16 packed{};
+    pack_pos(packed.pos, vertex.pos, dequant);
+    return packed;
+}
+
+VCW_AttribFloat VCW_AttribFloat::pack(const Vertex &vertex, glm::vec3, const VCW_PosDequant &) {
+    return {vertex.uv};
+}
+
+VCW_AttribPacked VCW_AttribPacked::pack(const Vertex &vertex, glm::vec3 normal, const VCW_PosDequant &) {
+    VCW_AttribPacked packed{};
+    pack_attribs(packed.uv, packed.normal, vertex, normal);
+    return packed;
+}
+
+VCW_VertPacked VCW_VertPacked::pack(const Vertex &vertex, glm::vec3 normal, const VCW_PosDequant &dequant) {
+    VCW_VertPacked packed{};
+    pack_pos(packed.pos, vertex.pos, dequant);
+    pack_attribs(packed.uv, packed.normal, vertex, normal);
+    return packed;
+}
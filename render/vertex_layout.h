@@ -0,0 +1,196 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#ifndef VCW_VERTEX_LAYOUT_H
+#define VCW_VERTEX_LAYOUT_H
+
+#include "../inc.h"
+#include "../prop.h"
+#include "mesh.h"
+
+#include <type_traits>
+
+// binding of the attribute stream, binding 0 holds the positions (or the whole vertex) and 1 the instances
+#define VERTEX_ATTRIB_BINDING 2
+
+struct VCW_VertexAttrib {
+    uint32_t location;
+    VkFormat format;
+    uint32_t offset;
+};
+
+// maps a mesh's positions into [-1, 1], the shader computes pos * scale + offset
+struct VCW_PosDequant {
+    glm::vec4 offset;
+    glm::vec4 scale;
+};
+
+//
+// streams, each one packs a source vertex and lists its attributes,
+// location 0 is the position, 1 the uv and 7 the octahedral normal (2 - 6 belong to the instance stream)
+//
+struct VCW_PosFloat {
+    glm::vec3 pos;
+
+    static constexpr std::array<VCW_VertexAttrib, 1> attribs = {{
+            {0, VK_FORMAT_R32G32B32_SFLOAT, 0},
+    }};
+
+    static VCW_PosFloat pack(const Vertex &vertex, glm::vec3 normal, const VCW_PosDequant &dequant);
+};
+
+// w is padding, three component 16 bit formats are optional as vertex input
+struct VCW_PosSnorm16 {
+    int16_t pos[4];
+
+    static constexpr std::array<VCW_VertexAttrib, 1> attribs = {{
+            {0, VK_FORMAT_R16G16B16A16_SNORM, 0},
+    }};
+
+    static VCW_PosSnorm16 pack(const Vertex &vertex, glm::vec3 normal, const VCW_PosDequant &dequant);
+};
+
+struct VCW_AttribFloat {
+    glm::vec2 uv;
+
+    static constexpr std::array<VCW_VertexAttrib, 1> attribs = {{
+            {1, VK_FORMAT_R32G32_SFLOAT, 0},
+    }};
+
+    static VCW_AttribFloat pack(const Vertex &vertex, glm::vec3 normal, const VCW_PosDequant &dequant);
+};
+
+struct VCW_AttribPacked {
+    uint16_t uv[2];
+    int16_t normal[2];
+
+    static constexpr std::array<VCW_VertexAttrib, 2> attribs = {{
+            {1, VK_FORMAT_R16G16_SFLOAT, 0},
+            {7, VK_FORMAT_R16G16_SNORM, 4},
+    }};
+
+    static VCW_AttribPacked pack(const Vertex &vertex, glm::vec3 normal, const VCW_PosDequant &dequant);
+};
+
+// the source vertex as is, uploaded without a copy
+struct VCW_VertFloat {
+    static constexpr std::array<VCW_VertexAttrib, 2> attribs = {{
+            {0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos)},
+            {1, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv)},
+    }};
+};
+
+struct VCW_VertPacked {
+    int16_t pos[4];
+    uint16_t uv[2];
+    int16_t normal[2];
+
+    static constexpr std::array<VCW_VertexAttrib, 3> attribs = {{
+            {0, VK_FORMAT_R16G16B16A16_SNORM, 0},
+            {1, VK_FORMAT_R16G16_SFLOAT, 8},
+            {7, VK_FORMAT_R16G16_SNORM, 12},
+    }};
+
+    static VCW_VertPacked pack(const Vertex &vertex, glm::vec3 normal, const VCW_PosDequant &dequant);
+};
+
+static_assert(sizeof(VCW_PosSnorm16) == 8 && sizeof(VCW_AttribPacked) == 8 && sizeof(VCW_VertPacked) == 16,
+              "packed streams must not be padded.");
+
+template<typename Stream>
+struct VCW_StreamType {
+    using type = Stream;
+};
+
+template<>
+struct VCW_StreamType<VCW_VertFloat> {
+    using type = Vertex;
+};
+
+template<typename Stream>
+struct VCW_StreamAttribCount {
+    static constexpr size_t value = Stream::attribs.size();
+};
+
+template<>
+struct VCW_StreamAttribCount<void> {
+    static constexpr size_t value = 0;
+};
+
+//
+// a layout is a position stream (binding 0) and an optional attribute stream (VERTEX_ATTRIB_BINDING),
+// the vertex input descriptions are built from the streams' attribute lists at compile time
+//
+template<typename PosStream, typename AttribStream = void>
+struct VCW_VertexLayout {
+    using pos_type = typename VCW_StreamType<PosStream>::type;
+    using attrib_type = AttribStream;
+
+    static constexpr bool split = !std::is_void_v<AttribStream>;
+    static constexpr bool quantized = !std::is_same_v<PosStream, VCW_VertFloat> &&
+                                      !std::is_same_v<PosStream, VCW_PosFloat>;
+    static constexpr uint32_t binding_count = split ? 2 : 1;
+    static constexpr size_t attrib_count = VCW_StreamAttribCount<PosStream>::value +
+                                           VCW_StreamAttribCount<AttribStream>::value;
+
+    static constexpr uint32_t get_vertex_size() {
+        if constexpr (split)
+            return sizeof(pos_type) + sizeof(AttribStream);
+        else
+            return sizeof(pos_type);
+    }
+
+    static constexpr std::array<VkVertexInputBindingDescription, binding_count> get_binding_descs() {
+        std::array<VkVertexInputBindingDescription, binding_count> binding_descs{};
+        binding_descs[0] = {0, sizeof(pos_type), VK_VERTEX_INPUT_RATE_VERTEX};
+        if constexpr (split)
+            binding_descs[1] = {VERTEX_ATTRIB_BINDING, sizeof(AttribStream), VK_VERTEX_INPUT_RATE_VERTEX};
+        return binding_descs;
+    }
+
+    static constexpr std::array<VkVertexInputAttributeDescription, attrib_count> get_attrib_descs() {
+        std::array<VkVertexInputAttributeDescription, attrib_count> attrib_descs{};
+        size_t i = 0;
+        for (const auto &attrib: PosStream::attribs)
+            attrib_descs[i++] = {attrib.location, 0, attrib.format, attrib.offset};
+        if constexpr (split)
+            for (const auto &attrib: AttribStream::attribs)
+                attrib_descs[i++] = {attrib.location, VERTEX_ATTRIB_BINDING, attrib.format, attrib.offset};
+        return attrib_descs;
+    }
+};
+
+#if defined(QUANTIZED_VERTICES) && defined(SPLIT_VERTEX_STREAMS)
+using VCW_Layout = VCW_VertexLayout<VCW_PosSnorm16, VCW_AttribPacked>;
+#elif defined(QUANTIZED_VERTICES)
+using VCW_Layout = VCW_VertexLayout<VCW_VertPacked>;
+#elif defined(SPLIT_VERTEX_STREAMS)
+using VCW_Layout = VCW_VertexLayout<VCW_PosFloat, VCW_AttribFloat>;
+#else
+using VCW_Layout = VCW_VertexLayout<VCW_VertFloat>;
+#endif
+
+VCW_PosDequant get_pos_dequant(std::span<const Vertex> vertices);
+
+// area weighted face normals, the source vertices carry none
+std::vector<glm::vec3> generate_normals(const VCW_Mesh &mesh);
+
+uint16_t float_to_half(float value);
+
+int16_t float_to_snorm16(float value);
+
+// octahedral mapping of a unit vector onto [-1, 1]^2
+glm::vec2 encode_oct(glm::vec3 normal);
+
+// the mesh's vertices in stream Stream's format
+template<typename Stream>
+std::vector<Stream> pack_stream(const VCW_Mesh &mesh, const std::vector<glm::vec3> &normals,
+                                const VCW_PosDequant &dequant) {
+    std::vector<Stream> stream(mesh.vertices.size());
+    for (size_t i = 0; i < stream.size(); i++)
+        stream[i] = Stream::pack(mesh.vertices[i], normals.empty() ? glm::vec3(0.0f) : normals[i], dequant);
+    return stream;
+}
+
+#endif //VCW_VERTEX_LAYOUT_H
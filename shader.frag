@@ -3,6 +3,12 @@
 // #define USE_UNIFORM
 // #define USE_PUSH_CONSTANTS
 // #define USE_SAMPLE_TEXTURE
+// #define USE_BINDLESS
+// #define USE_INSTANCING
+
+#ifdef USE_BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
 
 #ifdef USE_UNIFORM
 layout (binding = 0) uniform UBO {
@@ -10,24 +16,37 @@ layout (binding = 0) uniform UBO {
 } ubo;
 #endif
 
-#ifdef USE_PUSH_CONSTANTS
+#if defined(USE_PUSH_CONSTANTS) || defined(USE_BINDLESS)
 layout (push_constant) uniform PushConstants {
     mat4 view_proj;
     vec2 res;
     uint time;
+    uint tex_index;
 } pc;
 #endif
 
-#ifdef USE_SAMPLE_TEXTURE
+#ifdef USE_BINDLESS
+// set 1 is the bindless table, slots come from App::add_bindless_tex
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+#elif defined(USE_SAMPLE_TEXTURE)
 layout(binding = 0) uniform sampler2D tex_sampler;
 #endif
 
 layout(location = 1) in vec2 uv;
 
+#if defined(USE_BINDLESS) && defined(USE_INSTANCING)
+// bindless slot of the instance
+layout(location = 2) flat in uint material;
+#endif
+
 layout(location = 0) out vec4 out_col;
 
 void main() {
-    #ifdef USE_SAMPLE_TEXTURE
+    #if defined(USE_BINDLESS) && defined(USE_INSTANCING)
+    out_col = texture(textures[nonuniformEXT(material)], uv);
+    #elif defined(USE_BINDLESS)
+    out_col = texture(textures[pc.tex_index], uv);
+    #elif defined(USE_SAMPLE_TEXTURE)
     out_col = texture(tex_sampler, uv);
     #else
     out_col = vec4(uv, 1, 1);
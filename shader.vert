@@ -2,20 +2,84 @@
 
 // #define USE_UNIFORM
 #define USE_PUSH_CONSTANTS
+// #define USE_DYNAMIC_UNIFORM
+// #define USE_GPU_DRIVEN
+// #define USE_INSTANCING
+// #define USE_BINDLESS
+// #define USE_QUANTIZED_VERTICES
+
+// the object set follows the bindless table if there is one
+#ifdef USE_BINDLESS
+#define OBJECT_SET 2
+#else
+#define OBJECT_SET 1
+#endif
 
 #ifdef USE_PUSH_CONSTANTS
 layout (push_constant) uniform PushConstants {
     mat4 view_proj;
     vec2 res;
     uint time;
+    uint tex_index;
+#ifdef USE_QUANTIZED_VERTICES
+    // VCW_PosDequant of the drawn mesh
+    vec4 pos_offset;
+    vec4 pos_scale;
+#endif
 } pc;
 #endif
 
+#ifdef USE_DYNAMIC_UNIFORM
+// bound with a dynamic offset per draw, see App::alloc_dyn_unif
+layout (set = OBJECT_SET, binding = 0) uniform ObjectUBO {
+    mat4 model;
+} obj;
+#elif defined(USE_GPU_DRIVEN)
+// VCW_GpuInstance, gl_InstanceIndex is the first instance written by cull.comp (or the cpu draw loop)
+struct Instance {
+    mat4 model;
+    vec4 sphere;
+    uint index_count;
+    uint first_index;
+    int vertex_offset;
+    uint first_meshlet;
+    uint meshlet_count;
+    uint first_cluster;
+};
+
+layout (std430, set = OBJECT_SET, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+#endif
+
+// snorm16 and half float formats arrive as floats, only the position needs its scale
 layout (location = 0) in vec3 in_pos;
 layout (location = 1) in vec2 in_uv;
 
 layout (location = 1) out vec2 uv;
 
+#ifdef USE_QUANTIZED_VERTICES
+// octahedral, see encode_oct in render/vertex_layout.cpp
+layout (location = 7) in vec2 in_normal;
+
+layout (location = 3) out vec3 normal;
+
+vec3 decode_oct(vec2 oct) {
+    vec3 n = vec3(oct, 1.0 - abs(oct.x) - abs(oct.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+#endif
+
+#ifdef USE_INSTANCING
+// VCW_InstanceData, binding 1 advances per instance
+layout (location = 2) in mat4 in_model;
+layout (location = 6) in uint in_material;
+
+layout (location = 2) flat out uint material;
+#endif
+
 mat4 x = mat4(
     vec4(1.0, 0.0, 0.0, 0.0),
     vec4(0.0, -1.0, 0.0, 0.0),
@@ -24,10 +88,27 @@ mat4 x = mat4(
 );
 
 void main() {
+    #ifdef USE_QUANTIZED_VERTICES
+    vec4 pos = x * vec4(in_pos * pc.pos_scale.xyz + pc.pos_offset.xyz, 1.0);
+    normal = mat3(x) * decode_oct(in_normal);
+    #elif defined(USE_PUSH_CONSTANTS)
+    vec4 pos = x * vec4(in_pos, 1.0);
+    #else
+    vec4 pos = vec4(in_pos, 1.0);
+    #endif
+    #ifdef USE_DYNAMIC_UNIFORM
+    pos = obj.model * pos;
+    #elif defined(USE_GPU_DRIVEN)
+    pos = instances[gl_InstanceIndex].model * pos;
+    #elif defined(USE_INSTANCING)
+    pos = in_model * pos;
+    material = in_material;
+    #endif
+
     #ifdef USE_PUSH_CONSTANTS
-    gl_Position = pc.view_proj * x * vec4(in_pos, 1.0);
+    gl_Position = pc.view_proj * pos;
     #else
-    gl_Position = vec4(in_pos, 1.0);
+    gl_Position = pos;
     #endif
 
     uv = in_uv;
@@ -0,0 +1,99 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "thread_pool.h"
+
+// joins the workers if the app never reached clean_up, e.g. after a failed init
+VCW_ThreadPool::~VCW_ThreadPool() {
+    destroy();
+}
+
+void VCW_ThreadPool::create(uint32_t thread_count) {
+    stop = false;
+
+    for (uint32_t i = 0; i < thread_count; i++)
+        workers.emplace_back(&VCW_ThreadPool::work, this);
+}
+
+void VCW_ThreadPool::destroy() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    cv.notify_all();
+
+    for (auto &worker: workers)
+        worker.join();
+    workers.clear();
+}
+
+uint32_t VCW_ThreadPool::size() const {
+    return static_cast<uint32_t>(workers.size());
+}
+
+// claims partitions until none are left, fn is only touched after a successful claim
+void VCW_ParallelFor::run() {
+    while (true) {
+        uint32_t i = next.fetch_add(1);
+        if (i >= count)
+            return;
+
+        try {
+            (*p_fn)(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error)
+                error = std::current_exception();
+        }
+
+        if (done.fetch_add(1) + 1 == count) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cv.notify_all();
+        }
+    }
+}
+
+void VCW_ThreadPool::parallel_for(uint32_t count, const std::function<void(uint32_t)> &fn) {
+    if (count == 0)
+        return;
+
+    auto state = std::make_shared<VCW_ParallelFor>();
+    state->count = count;
+    state->p_fn = &fn;
+
+    // helpers that only start once a worker is free find every partition claimed and return right away
+    uint32_t helper_count = std::min(count - 1, size());
+    for (uint32_t i = 0; i < helper_count; i++)
+        submit([state]() { state->run(); }, true);
+
+    // the calling thread never waits for a partition nobody started, so busy workers can not stall it
+    state->run();
+
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cv.wait(lock, [&]() { return state->done.load() == count; });
+    }
+
+    if (state->error)
+        std::rethrow_exception(state->error);
+}
+
+void VCW_ThreadPool::work() {
+    while (true) {
+        std::function<void()> job;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]() { return stop || !jobs.empty(); });
+
+            if (stop && jobs.empty())
+                return;
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        job();
+    }
+}
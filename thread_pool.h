@@ -0,0 +1,75 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#ifndef VCW_THREAD_POOL_H
+#define VCW_THREAD_POOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <atomic>
+
+// partitions of one parallel_for, shared by the calling thread and the helper jobs
+struct VCW_ParallelFor {
+    uint32_t count = 0;
+    const std::function<void(uint32_t)> *p_fn = nullptr;
+    std::atomic<uint32_t> next = 0;
+    std::atomic<uint32_t> done = 0;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    void run();
+};
+
+class VCW_ThreadPool {
+public:
+    std::vector<std::thread> workers;
+
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop = false;
+
+    ~VCW_ThreadPool();
+
+    void create(uint32_t thread_count);
+
+    void destroy();
+
+    uint32_t size() const;
+
+    // urgent jobs go ahead of the queue, frame work must not wait behind background loads
+    template<typename F>
+    auto submit(F &&job, bool urgent = false) -> std::future<decltype(job())> {
+        using R = decltype(job());
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(job));
+        std::future<R> result = task->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (urgent)
+                jobs.emplace_front([task]() { (*task)(); });
+            else
+                jobs.emplace_back([task]() { (*task)(); });
+        }
+        cv.notify_one();
+
+        return result;
+    }
+
+    // runs fn(0) .. fn(count - 1) on the workers and the calling thread, returns when all are done.
+    // the calling thread takes every partition no worker has started yet
+    void parallel_for(uint32_t count, const std::function<void(uint32_t)> &fn);
+
+private:
+    void work();
+};
+
+#endif //VCW_THREAD_POOL_H
@@ -4,6 +4,17 @@
 
 #include "util.h"
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 std::vector<char> read_file(const std::string &filename) {
     std::ifstream file(filename, std::ios::ate | std::ios::binary);
 
@@ -21,7 +32,77 @@ std::vector<char> read_file(const std::string &filename) {
     return buf;
 }
 
+uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
 std::ostream &operator<<(std::ostream &os, const glm::vec3 &v) {
     os << "[" << v.x << ", " << v.y << ", " << v.z << "]";
     return os;
-}
\ No newline at end of file
+}
+
+VCW_MappedFile::~VCW_MappedFile() {
+    close();
+}
+
+void VCW_MappedFile::open(const std::string &filename) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("failed to open file.");
+
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+    size = static_cast<size_t>(file_size.QuadPart);
+
+    // the mapping keeps the file open, the file handle is not needed afterwards
+    HANDLE mapping = size > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle(file);
+    if (size > 0 && !mapping)
+        throw std::runtime_error("failed to map file.");
+
+    if (mapping) {
+        p_handle = mapping;
+        p_data = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!p_data) {
+            close();
+            throw std::runtime_error("failed to map file.");
+        }
+    }
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("failed to open file.");
+
+    struct stat file_stat{};
+    fstat(fd, &file_stat);
+    size = static_cast<size_t>(file_stat.st_size);
+
+    // the mapping keeps the file open, the descriptor is not needed afterwards
+    void *p_map = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+    ::close(fd);
+    if (p_map == MAP_FAILED) {
+        size = 0;
+        throw std::runtime_error("failed to map file.");
+    }
+    p_data = static_cast<const char *>(p_map);
+#endif
+}
+
+void VCW_MappedFile::close() {
+#ifdef _WIN32
+    if (p_data)
+        UnmapViewOfFile(p_data);
+    if (p_handle)
+        CloseHandle(p_handle);
+#else
+    if (p_data)
+        munmap(const_cast<char *>(p_data), size);
+#endif
+    p_data = nullptr;
+    p_handle = nullptr;
+    size = 0;
+}
@@ -9,6 +9,31 @@
 
 std::vector<char> read_file(const std::string &filename);
 
+uint64_t align_up(uint64_t value, uint64_t alignment);
+
 std::ostream& operator<<(std::ostream& os, const glm::vec3& v);
 
+// read only view of a whole file, the pages are loaded by the os on first access
+class VCW_MappedFile {
+public:
+    const char *p_data = nullptr;
+    size_t size = 0;
+
+    VCW_MappedFile() = default;
+
+    VCW_MappedFile(const VCW_MappedFile &) = delete;
+
+    VCW_MappedFile &operator=(const VCW_MappedFile &) = delete;
+
+    ~VCW_MappedFile();
+
+    void open(const std::string &filename);
+
+    void close();
+
+private:
+    // file mapping object on windows, unused elsewhere
+    void *p_handle = nullptr;
+};
+
 #endif //VCW_UTIL_H
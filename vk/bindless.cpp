@@ -0,0 +1,114 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "../app.h"
+
+//
+// one set shared by all frames, slots are written while frames in flight read other slots
+// (update after bind + update unused while pending), so a slot is only reused once no frame can reach it
+//
+void App::create_bindless() {
+    std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = bindless_tex_capacity;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = bindless_buf_capacity;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+    VkDescriptorBindingFlags binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                             VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                             VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+    bindless_set_layout = get_desc_set_layout(bindings, {binding_flags, binding_flags},
+                                              VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT);
+
+    VkDescriptorPoolSize pool_sizes[2];
+    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_sizes[0].descriptorCount = bindless_tex_capacity;
+    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_sizes[1].descriptorCount = bindless_buf_capacity;
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 2;
+    pool_info.pPoolSizes = pool_sizes;
+
+    if (vkCreateDescriptorPool(dev, &pool_info, nullptr, &bindless_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create bindless descriptor pool.");
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = bindless_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &bindless_set_layout;
+
+    if (vkAllocateDescriptorSets(dev, &alloc_info, &bindless_set) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate bindless descriptor set.");
+
+    // lowest slots are handed out first
+    for (uint32_t i = bindless_tex_capacity; i > 0; i--)
+        bindless_free_texs.push_back(i - 1);
+    for (uint32_t i = bindless_buf_capacity; i > 0; i--)
+        bindless_free_bufs.push_back(i - 1);
+}
+
+// no pipeline or layout changes, the slot is usable by the next recorded draw
+uint32_t App::add_bindless_tex(const VCW_Image &img) {
+    uint32_t index = reserve_bindless_tex();
+    write_bindless_tex(index, img);
+
+    return index;
+}
+
+// the slot stays unwritten, draws must not reach it before write_bindless_tex
+uint32_t App::reserve_bindless_tex() {
+    if (bindless_free_texs.empty())
+        throw std::runtime_error("bindless texture table is full.");
+
+    uint32_t index = bindless_free_texs.back();
+    bindless_free_texs.pop_back();
+
+    return index;
+}
+
+// rewrites the slot in place, no frame in flight may still sample it
+void App::write_bindless_tex(uint32_t index, const VCW_Image &img) {
+    VkDescriptorImageInfo img_info{};
+    img_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    img_info.imageView = img.view;
+    img_info.sampler = img.sampler;
+
+    // goes out with the frame's descriptor writes, before the next draw is recorded
+    write_img_desc_binding(img_info, bindless_set, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, index);
+}
+
+// frames in flight may still sample the slot
+void App::remove_bindless_tex(uint32_t index) {
+    defer_deletion([this, index]() { bindless_free_texs.push_back(index); });
+}
+
+uint32_t App::add_bindless_buf(const VCW_Buffer &buf) {
+    if (bindless_free_bufs.empty())
+        throw std::runtime_error("bindless buffer table is full.");
+
+    uint32_t index = bindless_free_bufs.back();
+    bindless_free_bufs.pop_back();
+
+    write_buf_desc_binding(buf, bindless_set, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, index);
+
+    return index;
+}
+
+void App::remove_bindless_buf(uint32_t index) {
+    defer_deletion([this, index]() { bindless_free_bufs.push_back(index); });
+}
+
+void App::clean_up_bindless() {
+    vkDestroyDescriptorPool(dev, bindless_pool, nullptr);
+}
@@ -4,22 +4,21 @@
 
 #include "../app.h"
 
-uint32_t App::find_mem_type(uint32_t type_filter, VkMemoryPropertyFlags mem_flags) {
-    VkPhysicalDeviceMemoryProperties mem_props;
-    vkGetPhysicalDeviceMemoryProperties(phy_dev, &mem_props);
+uint32_t App::find_mem_type(uint32_t type_filter, VkMemoryPropertyFlags mem_flags,
+                            VkMemoryPropertyFlags pref_mem_flags) {
+    int mem_type = resolve_mem_type(type_filter, mem_flags, pref_mem_flags);
 
-    for (uint32_t i = 0; i < mem_props.memoryTypeCount; i++) {
-        if ((type_filter & (1 << i)) && (mem_props.memoryTypes[i].propertyFlags & mem_flags) == mem_flags) {
-            return i;
-        }
-    }
+    if (mem_type < 0)
+        throw std::runtime_error("failed to find suitable memory type.");
 
-    throw std::runtime_error("failed to find suitable memory type.");
+    return static_cast<uint32_t>(mem_type);
 }
 
-VCW_Buffer App::create_buf(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags mem_props) {
+VCW_Buffer App::create_buf(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags mem_props,
+                           VkMemoryPropertyFlags pref_mem_props) {
     VCW_Buffer buf;
     buf.size = size;
+    buf.create_timeline_value = gfx_timeline_value;
 
     VkBufferCreateInfo buf_info{};
     buf_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -33,25 +32,20 @@ VCW_Buffer App::create_buf(VkDeviceSize size, VkBufferUsageFlags usage, VkMemory
     VkMemoryRequirements mem_reqs;
     vkGetBufferMemoryRequirements(dev, buf.buf, &mem_reqs);
 
-    VkMemoryAllocateInfo alloc_info{};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_reqs.size;
-    alloc_info.memoryTypeIndex = find_mem_type(mem_reqs.memoryTypeBits, mem_props);
+    buf.alloc = alloc_mem(mem_reqs, mem_props, pref_mem_props, true);
 
-    if (vkAllocateMemory(dev, &alloc_info, nullptr, &buf.mem) != VK_SUCCESS)
-        throw std::runtime_error("failed to allocate buffer memory.");
-
-    vkBindBufferMemory(dev, buf.buf, buf.mem, 0);
+    if (vkBindBufferMemory(dev, buf.buf, buf.alloc.mem, buf.alloc.offset) != VK_SUCCESS)
+        throw std::runtime_error("failed to bind buffer memory.");
 
     return buf;
 }
 
 void App::map_buf(VCW_Buffer *p_buf) {
-    vkMapMemory(dev, p_buf->mem, 0, p_buf->size, 0, &p_buf->p_mapped_mem);
+    p_buf->p_mapped_mem = map_mem(p_buf->alloc);
 }
 
+// the memory block stays mapped until it is freed
 void App::unmap_buf(VCW_Buffer *p_buf) {
-    vkUnmapMemory(dev, p_buf->mem);
     p_buf->p_mapped_mem = NULL;
 }
 
@@ -77,5 +71,5 @@ void App::cp_buf(VCW_Buffer src_buf, VCW_Buffer dst_buf) {
 
 void App::clean_up_buf(VCW_Buffer buf) {
     vkDestroyBuffer(dev, buf.buf, nullptr);
-    vkFreeMemory(dev, buf.mem, nullptr);
+    free_mem(buf.alloc);
 }
@@ -25,7 +25,11 @@ VCW_QueueFamilyIndices App::find_qf(VkPhysicalDevice loc_phy_dev) {
             loc_qf_indices.qf_graph = i;
 
         VkBool32 pres_support = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(loc_phy_dev, i, surf, &pres_support);
+        // nothing is presented in headless mode
+        if (headless)
+            loc_qf_indices.qf_pres = loc_qf_indices.qf_graph;
+        else
+            vkGetPhysicalDeviceSurfaceSupportKHR(loc_phy_dev, i, surf, &pres_support);
 
         if (pres_support)
             loc_qf_indices.qf_pres = i;
@@ -36,6 +40,27 @@ VCW_QueueFamilyIndices App::find_qf(VkPhysicalDevice loc_phy_dev) {
         i++;
     }
 
+#ifndef DISABLE_TRANSFER_QUEUE
+    if (!transfer_queue)
+        return loc_qf_indices;
+
+    // prefer a transfer-only family (dma engine), otherwise take an async compute family
+    for (uint32_t j = 0; j < loc_qf_props.size(); j++) {
+        VkQueueFlags flags = loc_qf_props[j].queueFlags;
+
+        if (flags & VK_QUEUE_GRAPHICS_BIT || !(flags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT)))
+            continue;
+
+        if (!(flags & VK_QUEUE_COMPUTE_BIT)) {
+            loc_qf_indices.qf_transfer = j;
+            break;
+        }
+
+        if (!loc_qf_indices.qf_transfer.has_value())
+            loc_qf_indices.qf_transfer = j;
+    }
+#endif
+
     return loc_qf_indices;
 }
 
@@ -54,6 +79,20 @@ bool App::check_phy_dev_ext_support(VkPhysicalDevice loc_phy_dev) {
     return required_exts.empty();
 }
 
+bool App::check_dev_ext_support(VkPhysicalDevice loc_phy_dev, const char *ext) {
+    uint32_t ext_count;
+    vkEnumerateDeviceExtensionProperties(loc_phy_dev, nullptr, &ext_count, nullptr);
+
+    std::vector<VkExtensionProperties> available_exts(ext_count);
+    vkEnumerateDeviceExtensionProperties(loc_phy_dev, nullptr, &ext_count, available_exts.data());
+
+    for (const auto &available: available_exts)
+        if (strcmp(available.extensionName, ext) == 0)
+            return true;
+
+    return false;
+}
+
 VCW_SwapSupport App::query_swap_support(VkPhysicalDevice loc_phy_dev) {
     VCW_SwapSupport support;
 
@@ -81,18 +120,44 @@ VCW_SwapSupport App::query_swap_support(VkPhysicalDevice loc_phy_dev) {
 bool App::is_phy_dev_suitable(VkPhysicalDevice loc_phy_dev) {
     VCW_QueueFamilyIndices loc_qf_indices = find_qf(loc_phy_dev);
 
-    bool exts_supported = check_phy_dev_ext_support(loc_phy_dev);
+    bool exts_supported = headless || check_phy_dev_ext_support(loc_phy_dev);
 
-    bool swap_adequate = false;
-    if (exts_supported) {
+    bool swap_adequate = headless;
+    if (exts_supported && !headless) {
         VCW_SwapSupport swap_support = query_swap_support(loc_phy_dev);
         swap_adequate = !swap_support.formats.empty() && !swap_support.pres_modes.empty();
     }
 
-    VkPhysicalDeviceFeatures features;
-    vkGetPhysicalDeviceFeatures(loc_phy_dev, &features);
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(loc_phy_dev, &props);
+    if (props.apiVersion < VK_API_VERSION_1_2)
+        return false;
+
+    // frame pacing is built on timeline semaphores
+    VkPhysicalDeviceVulkan12Features features_12{};
+    features_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &features_12;
+    vkGetPhysicalDeviceFeatures2(loc_phy_dev, &features);
+
+    bool bindless_supported = true;
+#ifdef BINDLESS
+    bindless_supported = features_12.runtimeDescriptorArray && features_12.descriptorBindingPartiallyBound &&
+                         features_12.descriptorBindingSampledImageUpdateAfterBind &&
+                         features_12.descriptorBindingStorageBufferUpdateAfterBind &&
+                         features_12.descriptorBindingUpdateUnusedWhilePending;
+#endif
+
+    // culled draws reference their instance through firstInstance
+    bool gpu_driven_supported = true;
+#ifdef GPU_DRIVEN
+    gpu_driven_supported = features.features.drawIndirectFirstInstance;
+#endif
 
-    return loc_qf_indices.is_complete() && exts_supported && swap_adequate && features.samplerAnisotropy;
+    return loc_qf_indices.is_complete() && exts_supported && swap_adequate && features.features.samplerAnisotropy &&
+           features_12.timelineSemaphore && bindless_supported && gpu_driven_supported;
 }
 
 void App::pick_phy_dev() {
@@ -117,6 +182,27 @@ void App::pick_phy_dev() {
 
     vkGetPhysicalDeviceMemoryProperties(phy_dev, &phy_dev_mem_props);
     vkGetPhysicalDeviceProperties(phy_dev, &phy_dev_props);
+
+#ifdef BINDLESS
+    VkPhysicalDeviceDescriptorIndexingProperties indexing_props{};
+    indexing_props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 props{};
+    props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    props.pNext = &indexing_props;
+    vkGetPhysicalDeviceProperties2(phy_dev, &props);
+
+    bindless_tex_capacity = std::min({static_cast<uint32_t>(BINDLESS_MAX_TEXTURES),
+                                      indexing_props.maxDescriptorSetUpdateAfterBindSampledImages,
+                                      indexing_props.maxDescriptorSetUpdateAfterBindSamplers,
+                                      indexing_props.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                      indexing_props.maxPerStageDescriptorUpdateAfterBindSamplers});
+    bindless_buf_capacity = std::min({static_cast<uint32_t>(BINDLESS_MAX_BUFFERS),
+                                      indexing_props.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                                      indexing_props.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+#endif
+
+    build_mem_type_lut();
 }
 
 void App::create_dev() {
@@ -124,6 +210,8 @@ void App::create_dev() {
 
     std::vector<VkDeviceQueueCreateInfo> queue_infos;
     std::set<uint32_t> q_families = {qf_indices.qf_graph.value(), qf_indices.qf_pres.value()};
+    if (qf_indices.qf_transfer.has_value())
+        q_families.insert(qf_indices.qf_transfer.value());
 
     float q_prior = 1.0f;
     for (uint32_t family: q_families) {
@@ -135,19 +223,58 @@ void App::create_dev() {
         queue_infos.push_back(queue_info);
     }
 
+    VkPhysicalDeviceVulkan12Features supported_features_12{};
+    supported_features_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 supported_features_2{};
+    supported_features_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported_features_2.pNext = &supported_features_12;
+    vkGetPhysicalDeviceFeatures2(phy_dev, &supported_features_2);
+    const VkPhysicalDeviceFeatures &supported_features = supported_features_2.features;
+
     VkPhysicalDeviceFeatures dev_features{};
     dev_features.samplerAnisotropy = VK_TRUE;
+    // optional, lets compute mip generation write any storage format
+    dev_features.shaderStorageImageWriteWithoutFormat = supported_features.shaderStorageImageWriteWithoutFormat;
+    storage_write_without_format = supported_features.shaderStorageImageWriteWithoutFormat;
+#ifdef GPU_DRIVEN
+    dev_features.drawIndirectFirstInstance = VK_TRUE;
+    dev_features.multiDrawIndirect = supported_features.multiDrawIndirect;
+    multi_draw_indirect = supported_features.multiDrawIndirect;
+#endif
+
+    VkPhysicalDeviceVulkan12Features dev_features_12{};
+    dev_features_12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    dev_features_12.timelineSemaphore = VK_TRUE;
+#ifdef GPU_DRIVEN
+    dev_features_12.drawIndirectCount = supported_features_12.drawIndirectCount;
+    draw_indirect_count = supported_features_12.drawIndirectCount;
+#endif
+#ifdef BINDLESS
+    dev_features_12.runtimeDescriptorArray = VK_TRUE;
+    dev_features_12.descriptorBindingPartiallyBound = VK_TRUE;
+    dev_features_12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    dev_features_12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    dev_features_12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+#endif
 
     VkDeviceCreateInfo dev_info{};
     dev_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    dev_info.pNext = &dev_features_12;
 
     dev_info.queueCreateInfoCount = static_cast<uint32_t>(queue_infos.size());
     dev_info.pQueueCreateInfos = queue_infos.data();
 
     dev_info.pEnabledFeatures = &dev_features;
 
-    dev_info.enabledExtensionCount = static_cast<uint32_t>(dev_exts.size());
-    dev_info.ppEnabledExtensionNames = dev_exts.data();
+    if (!headless)
+        enabled_dev_exts = dev_exts;
+    for (const char *ext: opt_dev_exts)
+        if (check_dev_ext_support(phy_dev, ext))
+            enabled_dev_exts.push_back(ext);
+
+    dev_info.enabledExtensionCount = static_cast<uint32_t>(enabled_dev_exts.size());
+    dev_info.ppEnabledExtensionNames = enabled_dev_exts.data();
 
 #ifdef VALIDATION
     dev_info.enabledLayerCount = static_cast<uint32_t>(val_layers.size());
@@ -162,4 +289,17 @@ void App::create_dev() {
     qf_props = get_qf_props(phy_dev);
     vkGetDeviceQueue(dev, qf_indices.qf_graph.value(), 0, &q_graph);
     vkGetDeviceQueue(dev, qf_indices.qf_pres.value(), 0, &q_pres);
+
+    dedicated_upload_queue = qf_indices.qf_transfer.has_value();
+    qf_upload = dedicated_upload_queue ? qf_indices.qf_transfer.value() : qf_indices.qf_graph.value();
+    vkGetDeviceQueue(dev, qf_upload, 0, &q_upload);
+    std::cout << "uploads on " << (dedicated_upload_queue ? "a dedicated" : "the graphics") << " queue (family "
+              << qf_upload << ")" << std::endl;
+
+    mem_budget_supported = check_dev_ext_support(phy_dev, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    push_desc_supported = check_dev_ext_support(phy_dev, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+    if (push_desc_supported)
+        p_cmd_push_desc_template = (PFN_vkCmdPushDescriptorSetWithTemplateKHR)
+                vkGetDeviceProcAddr(dev, "vkCmdPushDescriptorSetWithTemplateKHR");
+    update_mem_budget();
 }
\ No newline at end of file
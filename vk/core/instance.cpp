@@ -61,11 +61,15 @@ void App::init_window() {
 }
 
 std::vector<const char *> App::get_required_exts() {
-    uint32_t glfw_ext_count = 0;
-    const char **glfw_exts;
-    glfw_exts = glfwGetRequiredInstanceExtensions(&glfw_ext_count);
+    std::vector<const char *> exts;
 
-    std::vector<const char *> exts(glfw_exts, glfw_exts + glfw_ext_count);
+    if (!headless) {
+        uint32_t glfw_ext_count = 0;
+        const char **glfw_exts;
+        glfw_exts = glfwGetRequiredInstanceExtensions(&glfw_ext_count);
+
+        exts.assign(glfw_exts, glfw_exts + glfw_ext_count);
+    }
 
 #ifdef VALIDATION
     exts.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -86,7 +90,7 @@ void App::create_inst() {
     app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     app_info.pEngineName = ENGINE_NAME;
     app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    app_info.apiVersion = VK_API_VERSION_1_0;
+    app_info.apiVersion = VK_API_VERSION_1_2;
 
     VkInstanceCreateInfo inst_info{};
     inst_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -142,6 +146,7 @@ void App::init_imgui() {
     imgui_init_info.Device = dev;
     imgui_init_info.QueueFamily = qf_indices.qf_graph.value();
     imgui_init_info.Queue = q_graph;
+    imgui_init_info.PipelineCache = pipe_cache;
     imgui_init_info.DescriptorPool = desc_pool;
     imgui_init_info.RenderPass = rendp;
     imgui_init_info.Subpass = 0;
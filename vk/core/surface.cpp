@@ -46,7 +46,7 @@ VkExtent2D App::choose_extent(const VkSurfaceCapabilitiesKHR &caps) {
     }
 }
 
-void App::create_swap() {
+void App::create_swap(VkSwapchainKHR old_swap) {
     VCW_SwapSupport swap_support = query_swap_support(phy_dev);
 
     VkSurfaceFormatKHR surf_format = choose_surf_format(swap_support.formats);
@@ -82,6 +82,8 @@ void App::create_swap() {
     swap_info.compositeAlpha = PREFERRED_COMPOSITE_ALPHA;
     swap_info.presentMode = pres_mode;
     swap_info.clipped = VK_TRUE;
+    // lets the driver hand over resources while the old swapchain still presents its last frames
+    swap_info.oldSwapchain = old_swap;
 
     if (vkCreateSwapchainKHR(dev, &swap_info, nullptr, &swap) != VK_SUCCESS)
         throw std::runtime_error("failed to create swap chain.");
@@ -122,11 +124,11 @@ void App::recreate_swap() {
         glfwWaitEvents();
     }
 
-    vkDeviceWaitIdle(dev);
+    // no device wait, the old swapchain and everything sized by it retire through the deletion queue
+    VkSwapchainKHR old_swap = swap;
+    retire_swap();
 
-    clean_up_swap();
-
-    create_swap();
+    create_swap(old_swap);
 #ifdef ENABLE_DEPTH_TESTING
     create_depth_resources();
 #endif
@@ -144,6 +146,42 @@ void App::recreate_swap() {
     ImGui_ImplVulkan_SetMinImageCount(static_cast<uint32_t>(swap_imgs.size()));
 }
 
+// hands the current swapchain objects to the deletion queue, frames in flight may still use them
+void App::retire_swap() {
+    std::vector<VkFramebuffer> old_frame_bufs = frame_bufs;
+    std::vector<VCW_Image> old_swap_imgs = swap_imgs;
+    std::vector<VCW_Image> old_render_targets = render_targets;
+#ifdef ENABLE_DEPTH_TESTING
+    VCW_Image old_depth_img = depth_img;
+#endif
+    VkSwapchainKHR old_swap = swap;
+
+    defer_deletion([=, this]() {
+#ifdef ENABLE_DEPTH_TESTING
+        clean_up_img(old_depth_img);
+#endif
+        for (auto framebuffer: old_frame_bufs)
+            vkDestroyFramebuffer(dev, framebuffer, nullptr);
+
+        for (auto img: old_render_targets)
+            clean_up_img(img);
+    });
+
+    // the timeline only covers rendering, a present of an old image can still be pending after its frame completed
+    // and nothing signals its end without VK_EXT_swapchain_maintenance1 present fences, so the swapchain and its
+    // views wait until frames_in_flight more submissions, each behind an acquire of the new swapchain, are done
+    defer_deletion([=, this]() {
+        for (auto img: old_swap_imgs)
+            vkDestroyImageView(dev, img.view, nullptr);
+
+        vkDestroySwapchainKHR(dev, old_swap, nullptr);
+    }, frames_in_flight);
+
+    frame_bufs.clear();
+    swap_imgs.clear();
+    render_targets.clear();
+}
+
 void App::clean_up_swap() {
 #ifdef ENABLE_DEPTH_TESTING
     clean_up_img(depth_img);
@@ -151,16 +189,16 @@ void App::clean_up_swap() {
 
     for (auto framebuffer: frame_bufs)
         vkDestroyFramebuffer(dev, framebuffer, nullptr);
+    frame_bufs.clear();
 
     for (auto img: swap_imgs)
         vkDestroyImageView(dev, img.view, nullptr);
     swap_imgs.clear();
 
-#ifdef INTERMEDIATE_RENDER_TARGET
     for (auto img: render_targets)
         clean_up_img(img);
     render_targets.clear();
-#endif
 
-    vkDestroySwapchainKHR(dev, swap, nullptr);
+    if (!headless)
+        vkDestroySwapchainKHR(dev, swap, nullptr);
 }
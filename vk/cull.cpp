@@ -0,0 +1,218 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "../app.h"
+
+//
+// the graphics pipeline reads the instances through the object set, the cull pass reads them and writes
+// the indirect commands of the current frame's region through a dynamic offset
+//
+void App::create_cull_pipe() {
+    VkDescriptorSetLayoutBinding instance_binding{};
+    instance_binding.binding = 0;
+    instance_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    instance_binding.descriptorCount = 1;
+    instance_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    object_set_layout = get_desc_set_layout({instance_binding});
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+    bindings[0] = instance_binding;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1] = bindings[0];
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+#ifdef MESHLETS
+    // the clusters of all meshes
+    bindings.push_back(bindings[0]);
+    bindings[2].binding = 2;
+#endif
+    cull_set_layout = get_desc_set_layout(bindings);
+
+    std::array<VkDescriptorPoolSize, 2> pool_sizes = {{
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3},
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1},
+    }};
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+    pool_info.maxSets = 2;
+
+    if (vkCreateDescriptorPool(dev, &pool_info, nullptr, &gpu_driven_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create gpu driven descriptor pool.");
+
+    std::array<VkDescriptorSetLayout, 2> set_layouts = {object_set_layout, cull_set_layout};
+    std::array<VkDescriptorSet, 2> sets{};
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = gpu_driven_pool;
+    alloc_info.descriptorSetCount = static_cast<uint32_t>(set_layouts.size());
+    alloc_info.pSetLayouts = set_layouts.data();
+
+    if (vkAllocateDescriptorSets(dev, &alloc_info, sets.data()) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate gpu driven descriptor sets.");
+    object_set = sets[0];
+    cull_set = sets[1];
+
+    VkPushConstantRange push_const_range{};
+    push_const_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_const_range.offset = 0;
+    push_const_range.size = sizeof(VCW_CullPushConstants);
+
+    VkPipelineLayoutCreateInfo pipe_layout_info{};
+    pipe_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipe_layout_info.setLayoutCount = 1;
+    pipe_layout_info.pSetLayouts = &cull_set_layout;
+    pipe_layout_info.pushConstantRangeCount = 1;
+    pipe_layout_info.pPushConstantRanges = &push_const_range;
+
+    if (vkCreatePipelineLayout(dev, &pipe_layout_info, nullptr, &cull_pipe_layout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create cull pipeline layout.");
+
+    VkShaderModule comp_module = create_shader_mod(read_file("cull.spv"));
+
+    VkComputePipelineCreateInfo pipe_info{};
+    pipe_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipe_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipe_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipe_info.stage.module = comp_module;
+    pipe_info.stage.pName = "main";
+    pipe_info.layout = cull_pipe_layout;
+
+    if (vkCreateComputePipelines(dev, pipe_cache, 1, &pipe_info, nullptr, &cull_pipe) != VK_SUCCESS)
+        throw std::runtime_error("failed to create cull pipeline.");
+
+    vkDestroyShaderModule(dev, comp_module, nullptr);
+}
+
+// the draws are static, their instances are uploaded once
+void App::create_instance_bufs() {
+    std::vector<VCW_GpuInstance> instances(draws.size());
+    indirect_cmd_count = 0;
+    for (size_t i = 0; i < draws.size(); i++) {
+        const VCW_MeshRange &mesh = meshes[draws[i].mesh_index];
+        instances[i].model = draws[i].model;
+        instances[i].sphere = meshes[draws[i].mesh_index].sphere;
+        // the culling pass draws the full mesh, only the cpu draw path picks detail levels
+        instances[i].index_count = mesh.index_count;
+        instances[i].first_index = mesh.first_index;
+        instances[i].vertex_offset = draws[i].vertex_offset;
+        instances[i].first_meshlet = mesh.first_meshlet;
+        instances[i].meshlet_count = mesh.meshlet_count;
+        instances[i].first_cluster = indirect_cmd_count;
+#ifdef MESHLETS
+        indirect_cmd_count += mesh.meshlet_count;
+#else
+        indirect_cmd_count++;
+#endif
+    }
+
+    VkDeviceSize instances_size = sizeof(VCW_GpuInstance) * instances.size();
+    instance_buf = create_buf(instances_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, static_pref_mem_props);
+    upload_to_buf(instance_buf, instances.data(), instances_size);
+
+    // draw count followed by one command slot per instance (or cluster)
+    VkDeviceSize align = phy_dev_props.limits.minStorageBufferOffsetAlignment;
+    VkDeviceSize cmds_size = sizeof(uint32_t) + sizeof(VkDrawIndexedIndirectCommand) * indirect_cmd_count;
+    indirect_frame_size = (cmds_size + align - 1) / align * align;
+
+    indirect_buf = create_buf(indirect_frame_size * frames_in_flight,
+                              VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                              VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    write_buf_desc_binding(instance_buf, object_set, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    write_buf_desc_binding(instance_buf, cull_set, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    write_buf_desc_binding({indirect_buf.buf, 0, cmds_size}, cull_set, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC);
+
+#ifdef MESHLETS
+    VkDeviceSize meshlets_size = sizeof(VCW_GpuMeshlet) * gpu_meshlets.size();
+    meshlet_buf = create_buf(meshlets_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, static_pref_mem_props);
+    upload_to_buf(meshlet_buf, gpu_meshlets.data(), meshlets_size);
+    write_buf_desc_binding(meshlet_buf, cull_set, 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+#endif
+}
+
+// outside the render pass, before the draws consume the commands
+void App::record_cull(VkCommandBuffer cmd_buf) {
+    uint32_t frame_offset = static_cast<uint32_t>(cur_frame * indirect_frame_size);
+    uint32_t instance_count = static_cast<uint32_t>(draws.size());
+
+    vkCmdFillBuffer(cmd_buf, indirect_buf.buf, frame_offset, sizeof(uint32_t), 0);
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = indirect_buf.buf;
+    barrier.offset = frame_offset;
+    barrier.size = indirect_frame_size;
+
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr,
+                         1, &barrier, 0, nullptr);
+
+    VCW_CullPushConstants cull_const{};
+    std::array<glm::vec4, 6> planes = cam.get_frustum_planes();
+    std::copy(planes.begin(), planes.end(), cull_const.planes);
+    cull_const.instance_count = instance_count;
+    // the count path is limited to maxDrawIndirectCount draws in one call
+    cull_const.compact = draw_indirect_count && indirect_cmd_count <= phy_dev_props.limits.maxDrawIndirectCount;
+    cull_const.cam_pos = glm::vec4(cam.pos, 1.0f);
+
+    vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_COMPUTE, cull_pipe);
+    vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_COMPUTE, cull_pipe_layout, 0, 1, &cull_set, 1,
+                            &frame_offset);
+    vkCmdPushConstants(cmd_buf, cull_pipe_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(VCW_CullPushConstants),
+                       &cull_const);
+#ifdef MESHLETS
+    // a workgroup per instance, its invocations share the instance's clusters. beyond the limit
+    // (65535 on lavapipe) the workgroups loop over the remaining instances
+    vkCmdDispatch(cmd_buf, std::min(instance_count, phy_dev_props.limits.maxComputeWorkGroupCount[0]), 1, 1);
+#else
+    vkCmdDispatch(cmd_buf, (instance_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+#endif
+
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+    vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0,
+                         nullptr, 1, &barrier, 0, nullptr);
+}
+
+// inside the render pass, the pipeline and sets are bound
+void App::record_indirect_draws(VkCommandBuffer cmd_buf) {
+    VkDeviceSize frame_offset = cur_frame * indirect_frame_size;
+    VkDeviceSize cmds_offset = frame_offset + sizeof(uint32_t);
+    uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    uint32_t max_draws = phy_dev_props.limits.maxDrawIndirectCount;
+
+    if (draw_indirect_count && indirect_cmd_count <= max_draws) {
+        vkCmdDrawIndexedIndirectCount(cmd_buf, indirect_buf.buf, cmds_offset, indirect_buf.buf, frame_offset,
+                                      indirect_cmd_count, stride);
+        return;
+    }
+
+    // every instance (or cluster) has its own slot, culled ones draw zero instances
+    uint32_t draws_per_call = multi_draw_indirect ? max_draws : 1;
+    for (uint32_t first = 0; first < indirect_cmd_count; first += draws_per_call)
+        vkCmdDrawIndexedIndirect(cmd_buf, indirect_buf.buf, cmds_offset + first * stride,
+                                 std::min(draws_per_call, indirect_cmd_count - first), stride);
+}
+
+void App::clean_up_gpu_driven() {
+    vkDestroyPipeline(dev, cull_pipe, nullptr);
+    vkDestroyPipelineLayout(dev, cull_pipe_layout, nullptr);
+    vkDestroyDescriptorPool(dev, gpu_driven_pool, nullptr);
+
+    clean_up_buf(instance_buf);
+    clean_up_buf(indirect_buf);
+#ifdef MESHLETS
+    clean_up_buf(meshlet_buf);
+#endif
+}
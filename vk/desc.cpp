@@ -4,17 +4,71 @@
 
 #include "../app.h"
 
-void App::add_desc_set_layout(uint32_t binding_count, VkDescriptorSetLayoutBinding *p_bindings) {
+bool VCW_DescLayoutKey::operator==(const VCW_DescLayoutKey &other) const {
+    if (flags != other.flags || binding_flags != other.binding_flags || bindings.size() != other.bindings.size())
+        return false;
+
+    for (size_t i = 0; i < bindings.size(); i++) {
+        const VkDescriptorSetLayoutBinding &a = bindings[i];
+        const VkDescriptorSetLayoutBinding &b = other.bindings[i];
+
+        if (a.binding != b.binding || a.descriptorType != b.descriptorType ||
+            a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags ||
+            a.pImmutableSamplers != b.pImmutableSamplers)
+            return false;
+    }
+
+    return true;
+}
+
+size_t VCW_DescLayoutKeyHash::operator()(const VCW_DescLayoutKey &key) const {
+    size_t hash = 0;
+    auto combine = [&hash](uint64_t value) {
+        hash ^= std::hash<uint64_t>{}(value) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    };
+
+    combine(key.flags);
+    for (const auto &binding: key.bindings) {
+        combine(binding.binding);
+        combine(binding.descriptorType);
+        combine(binding.descriptorCount);
+        combine(binding.stageFlags);
+    }
+    for (VkDescriptorBindingFlags binding_flags: key.binding_flags)
+        combine(binding_flags);
+
+    return hash;
+}
+
+// the cache owns every layout until clean_up_desc
+VkDescriptorSetLayout App::get_desc_set_layout(const std::vector<VkDescriptorSetLayoutBinding> &bindings,
+                                               const std::vector<VkDescriptorBindingFlags> &binding_flags,
+                                               VkDescriptorSetLayoutCreateFlags flags) {
+    VCW_DescLayoutKey key{bindings, binding_flags, flags};
+
+    auto cached = desc_layout_cache.find(key);
+    if (cached != desc_layout_cache.end())
+        return cached->second;
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{};
+    binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    binding_flags_info.bindingCount = static_cast<uint32_t>(binding_flags.size());
+    binding_flags_info.pBindingFlags = binding_flags.data();
+
     VkDescriptorSetLayoutCreateInfo desc_set_layout_info{};
     desc_set_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    desc_set_layout_info.bindingCount = binding_count;
-    desc_set_layout_info.pBindings = p_bindings;
+    desc_set_layout_info.pNext = binding_flags.empty() ? nullptr : &binding_flags_info;
+    desc_set_layout_info.flags = flags;
+    desc_set_layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+    desc_set_layout_info.pBindings = bindings.data();
 
     VkDescriptorSetLayout desc_set_layout;
     if (vkCreateDescriptorSetLayout(dev, &desc_set_layout_info, nullptr, &desc_set_layout) != VK_SUCCESS)
         throw std::runtime_error("failed to create descriptor set layout.");
 
-    desc_set_layouts.push_back(desc_set_layout);
+    desc_layout_cache.emplace(std::move(key), desc_set_layout);
+
+    return desc_set_layout;
 }
 
 void App::add_pool_size(uint32_t desc_count, VkDescriptorType desc_type) {
@@ -34,58 +88,333 @@ void App::create_desc_pool(uint32_t max_sets) {
 
     if (vkCreateDescriptorPool(dev, &pool_info, nullptr, &desc_pool) != VK_SUCCESS)
         throw std::runtime_error("failed to create descriptor pool.");
+}
+
+//
+// per frame pools are never freed from, they are reset as a whole when their frame slot comes around again
+//
+VkDescriptorPool App::create_frame_desc_pool(uint32_t max_sets) {
+    // rough mix per set, a pool running out of one type is simply followed by the next one
+    std::array<VkDescriptorPoolSize, 5> pool_sizes = {{
+            {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, max_sets * 2},
+            {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, max_sets},
+            {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, max_sets * 4},
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, max_sets * 2},
+            {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, max_sets},
+    }};
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+    pool_info.maxSets = max_sets;
+
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(dev, &pool_info, nullptr, &pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create frame descriptor pool.");
+
+    return pool;
+}
+
+void App::create_frame_desc_allocs() {
+    frame_desc_allocs.resize(frames_in_flight);
+    for (auto &desc_alloc: frame_desc_allocs) {
+        desc_alloc.pools.push_back(create_frame_desc_pool(DESC_POOL_INITIAL_SETS));
+        desc_alloc.cur_pool = 0;
+        desc_alloc.set_count = 0;
+    }
+
+    desc_sets.resize(frames_in_flight);
+}
+
+// the set is valid until the frame slot is reset
+VkDescriptorSet App::alloc_frame_desc_set(uint32_t frame, VkDescriptorSetLayout layout) {
+    VCW_DescAllocator &desc_alloc = frame_desc_allocs[frame];
 
     VkDescriptorSetAllocateInfo alloc_info{};
     alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    alloc_info.descriptorPool = desc_pool;
-    alloc_info.descriptorSetCount = static_cast<uint32_t>(desc_set_layouts.size());
-    alloc_info.pSetLayouts = desc_set_layouts.data();
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &layout;
+
+    bool new_pool = false;
+    while (true) {
+        alloc_info.descriptorPool = desc_alloc.pools[desc_alloc.cur_pool];
+
+        VkDescriptorSet desc_set;
+        VkResult result = vkAllocateDescriptorSets(dev, &alloc_info, &desc_set);
+        if (result == VK_SUCCESS) {
+            desc_alloc.set_count++;
+            return desc_set;
+        }
+
+        if (new_pool || (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL))
+            throw std::runtime_error("failed to allocate descriptor set.");
+
+        // pools kept from earlier frames are tried first, growing ones keep the pool count of busy frames low
+        desc_alloc.cur_pool++;
+        if (desc_alloc.cur_pool == desc_alloc.pools.size()) {
+            uint32_t max_sets = std::min(DESC_POOL_INITIAL_SETS << std::min(desc_alloc.cur_pool, 16u),
+                                         DESC_POOL_MAX_SETS);
+            desc_alloc.pools.push_back(create_frame_desc_pool(max_sets));
+            new_pool = true;
+        }
+    }
+}
 
-    desc_sets.resize(desc_set_layouts.size());
-    if (vkAllocateDescriptorSets(dev, &alloc_info, desc_sets.data()) != VK_SUCCESS)
-        throw std::runtime_error("failed to allocate descriptor sets.");
+// the frame's last submission has completed
+void App::reset_frame_desc_pools(uint32_t frame) {
+    VCW_DescAllocator &desc_alloc = frame_desc_allocs[frame];
+
+    for (auto &pool: desc_alloc.pools)
+        vkResetDescriptorPool(dev, pool, 0);
+
+    desc_alloc.cur_pool = 0;
+    desc_alloc.set_count = 0;
 }
 
-void App::write_buf_desc_binding(VCW_Buffer buf, uint32_t dst_set, uint32_t dst_binding, VkDescriptorType desc_type) {
+//
+// writes are queued and go out together with flush_desc_writes
+//
+void App::write_buf_desc_binding(VCW_Buffer buf, VkDescriptorSet dst_set, uint32_t dst_binding,
+                                 VkDescriptorType desc_type, uint32_t dst_element) {
     VkDescriptorBufferInfo buf_info{};
     buf_info.buffer = buf.buf;
     buf_info.offset = 0;
     buf_info.range = buf.size;
 
+    write_buf_desc_binding(buf_info, dst_set, dst_binding, desc_type, dst_element);
+}
+
+void App::write_buf_desc_binding(VkDescriptorBufferInfo buf_info, VkDescriptorSet dst_set, uint32_t dst_binding,
+                                 VkDescriptorType desc_type, uint32_t dst_element) {
+    desc_buf_infos.push_back(buf_info);
+
     VkWriteDescriptorSet write{};
     write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write.dstSet = desc_sets[dst_set];
+    write.dstSet = dst_set;
     write.dstBinding = dst_binding;
-    write.dstArrayElement = 0;
+    write.dstArrayElement = dst_element;
     write.descriptorType = desc_type;
     write.descriptorCount = 1;
-    write.pBufferInfo = &buf_info;
+    write.pBufferInfo = &desc_buf_infos.back();
 
-    vkUpdateDescriptorSets(dev, 1, &write, 0, nullptr);
+    desc_writes.push_back(write);
 }
 
-void App::write_img_desc_binding(VCW_Image img, uint32_t dst_set, uint32_t dst_binding, VkDescriptorType desc_type) {
+void App::write_img_desc_binding(VCW_Image img, VkDescriptorSet dst_set, uint32_t dst_binding,
+                                 VkDescriptorType desc_type) {
     VkDescriptorImageInfo img_info{};
     img_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     img_info.imageView = img.view;
     if (img.has_sampler)
         img_info.sampler = img.sampler;
 
+    write_img_desc_binding(img_info, dst_set, dst_binding, desc_type);
+}
+
+void App::write_img_desc_binding(VkDescriptorImageInfo img_info, VkDescriptorSet dst_set, uint32_t dst_binding,
+                                 VkDescriptorType desc_type, uint32_t dst_element) {
+    desc_img_infos.push_back(img_info);
+
     VkWriteDescriptorSet write{};
     write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write.dstSet = desc_sets[dst_set];
+    write.dstSet = dst_set;
     write.dstBinding = dst_binding;
-    write.dstArrayElement = 0;
+    write.dstArrayElement = dst_element;
     write.descriptorType = desc_type;
     write.descriptorCount = 1;
-    write.pImageInfo = &img_info;
+    write.pImageInfo = &desc_img_infos.back();
 
-    vkUpdateDescriptorSets(dev, 1, &write, 0, nullptr);
+    desc_writes.push_back(write);
+}
+
+void App::flush_desc_writes() {
+    if (desc_writes.empty())
+        return;
+
+    vkUpdateDescriptorSets(dev, static_cast<uint32_t>(desc_writes.size()), desc_writes.data(), 0, nullptr);
+
+    desc_writes.clear();
+    desc_buf_infos.clear();
+    desc_img_infos.clear();
 }
 
 void App::clean_up_desc() {
+    if (frame_desc_template != VK_NULL_HANDLE)
+        vkDestroyDescriptorUpdateTemplate(dev, frame_desc_template, nullptr);
+
+    for (auto &desc_alloc: frame_desc_allocs)
+        for (auto &pool: desc_alloc.pools)
+            vkDestroyDescriptorPool(dev, pool, nullptr);
+    frame_desc_allocs.clear();
+
+#ifdef IMPL_IMGUI
     vkDestroyDescriptorPool(dev, desc_pool, nullptr);
-    for (auto &desc_set_layout: desc_set_layouts) {
+#endif
+
+    for (auto &[key, desc_set_layout]: desc_layout_cache)
         vkDestroyDescriptorSetLayout(dev, desc_set_layout, nullptr);
+    desc_layout_cache.clear();
+}
+
+//
+// one entry per binding, the infos of all bindings follow each other in one VCW_DescInfo array
+//
+VkDescriptorUpdateTemplate App::create_desc_template(const std::vector<VkDescriptorSetLayoutBinding> &bindings,
+                                                     VkDescriptorSetLayout layout, VkPipelineLayout push_pipe_layout,
+                                                     uint32_t push_set) {
+    std::vector<VkDescriptorUpdateTemplateEntry> entries;
+    size_t desc_index = 0;
+    for (const auto &binding: bindings) {
+        VkDescriptorUpdateTemplateEntry entry{};
+        entry.dstBinding = binding.binding;
+        entry.dstArrayElement = 0;
+        entry.descriptorCount = binding.descriptorCount;
+        entry.descriptorType = binding.descriptorType;
+        entry.offset = desc_index * sizeof(VCW_DescInfo);
+        entry.stride = sizeof(VCW_DescInfo);
+        entries.push_back(entry);
+
+        desc_index += binding.descriptorCount;
+    }
+
+    VkDescriptorUpdateTemplateCreateInfo template_info{};
+    template_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    template_info.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+    template_info.pDescriptorUpdateEntries = entries.data();
+    template_info.descriptorSetLayout = layout;
+
+    // a push template is bound to the pipeline layout and set it pushes into
+    if (push_pipe_layout != VK_NULL_HANDLE) {
+        template_info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR;
+        template_info.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        template_info.pipelineLayout = push_pipe_layout;
+        template_info.set = push_set;
+    } else {
+        template_info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    }
+
+    VkDescriptorUpdateTemplate desc_template;
+    if (vkCreateDescriptorUpdateTemplate(dev, &template_info, nullptr, &desc_template) != VK_SUCCESS)
+        throw std::runtime_error("failed to create descriptor update template.");
+
+    return desc_template;
+}
+
+//
+// writes the same set of DESC_BENCH_BINDINGS uniform buffers per binding, as one batch, with a template and
+// as push descriptors, push descriptors only measure recording since they are copied into the command buffer
+//
+void App::bench_desc_updates(uint32_t iterations) {
+    VCW_Buffer buf = create_buf(256, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings(DESC_BENCH_BINDINGS);
+    for (uint32_t i = 0; i < DESC_BENCH_BINDINGS; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    VkDescriptorSetLayout layout = get_desc_set_layout(bindings);
+
+    VkDescriptorPoolSize pool_size{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, DESC_BENCH_BINDINGS};
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    pool_info.maxSets = 1;
+
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(dev, &pool_info, nullptr, &pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create descriptor benchmark pool.");
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &layout;
+
+    VkDescriptorSet desc_set;
+    if (vkAllocateDescriptorSets(dev, &alloc_info, &desc_set) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate descriptor benchmark set.");
+
+    std::vector<VkDescriptorBufferInfo> buf_infos(DESC_BENCH_BINDINGS, {buf.buf, 0, buf.size});
+    std::vector<VkWriteDescriptorSet> writes(DESC_BENCH_BINDINGS);
+    std::vector<VCW_DescInfo> desc_data(DESC_BENCH_BINDINGS);
+    for (uint32_t i = 0; i < DESC_BENCH_BINDINGS; i++) {
+        writes[i] = {};
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = desc_set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        writes[i].descriptorCount = 1;
+        writes[i].pBufferInfo = &buf_infos[i];
+
+        desc_data[i].buf = buf_infos[i];
+    }
+
+    auto time_per_set = [iterations](const std::function<void()> &update) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < iterations; i++)
+            update();
+        auto end_time = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::micro>(end_time - start_time).count() / iterations;
+    };
+
+    // nothing queued by earlier code should be timed
+    flush_desc_writes();
+
+    double binding_time = time_per_set([&]() {
+        for (const auto &write: writes)
+            vkUpdateDescriptorSets(dev, 1, &write, 0, nullptr);
+    });
+
+    double batch_time = time_per_set([&]() {
+        for (uint32_t i = 0; i < DESC_BENCH_BINDINGS; i++)
+            write_buf_desc_binding(buf, desc_set, i, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+        flush_desc_writes();
+    });
+
+    VkDescriptorUpdateTemplate set_template = create_desc_template(bindings, layout);
+    double template_time = time_per_set([&]() {
+        vkUpdateDescriptorSetWithTemplate(dev, desc_set, set_template, desc_data.data());
+    });
+
+    double push_time = 0.0;
+    if (push_desc_supported) {
+        VkDescriptorSetLayout push_layout = get_desc_set_layout(bindings, {},
+                                                                VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR);
+
+        VkPipelineLayoutCreateInfo pipe_layout_info{};
+        pipe_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipe_layout_info.setLayoutCount = 1;
+        pipe_layout_info.pSetLayouts = &push_layout;
+
+        VkPipelineLayout push_pipe_layout;
+        if (vkCreatePipelineLayout(dev, &pipe_layout_info, nullptr, &push_pipe_layout) != VK_SUCCESS)
+            throw std::runtime_error("failed to create descriptor benchmark pipeline layout.");
+
+        VkDescriptorUpdateTemplate push_template = create_desc_template(bindings, push_layout, push_pipe_layout);
+
+        VkCommandBuffer cmd_buf = begin_single_time_cmd();
+        push_time = time_per_set([&]() {
+            p_cmd_push_desc_template(cmd_buf, push_template, push_pipe_layout, 0, desc_data.data());
+        });
+        end_single_time_cmd(cmd_buf);
+
+        vkDestroyDescriptorUpdateTemplate(dev, push_template, nullptr);
+        vkDestroyPipelineLayout(dev, push_pipe_layout, nullptr);
     }
-}
\ No newline at end of file
+
+    vkDestroyDescriptorUpdateTemplate(dev, set_template, nullptr);
+    vkDestroyDescriptorPool(dev, pool, nullptr);
+    clean_up_buf(buf);
+
+    std::cout << "descriptor updates (" << DESC_BENCH_BINDINGS << " uniform buffers, " << iterations
+              << " sets): per binding " << binding_time << "us, batched " << batch_time << "us, template "
+              << template_time << "us";
+    if (push_desc_supported)
+        std::cout << ", push " << push_time << "us";
+    std::cout << " per set" << std::endl;
+}
@@ -0,0 +1,221 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "../app.h"
+
+//
+// all meshes share one vertex and one index buffer, a mesh is a range of both that draws reach through
+// firstIndex / vertexOffset, so the buffers are bound once per command buffer.
+// vertex_capacity counts the bytes of all vertex streams, each stream holds the same number of vertices
+//
+void App::create_geometry_store(VkDeviceSize vertex_capacity, VkDeviceSize index_capacity) {
+    VkDeviceSize max_vertices = vertex_capacity / VCW_Layout::get_vertex_size();
+    vert_buf = create_buf(max_vertices * sizeof(VCW_Layout::pos_type),
+                          VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, static_pref_mem_props);
+#ifdef SPLIT_VERTEX_STREAMS
+    attrib_buf = create_buf(max_vertices * sizeof(VCW_Layout::attrib_type),
+                            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, static_pref_mem_props);
+#endif
+    index_buf = create_buf(index_capacity, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, static_pref_mem_props);
+    geo_vert_head = 0;
+    geo_index_head = 0;
+    meshes.clear();
+    gpu_meshlets.clear();
+}
+
+// ranges are never freed, the store lives as long as the scene
+uint32_t App::add_mesh(const VCW_Mesh &mesh) {
+    if (mesh.vertices.empty() || mesh.get_index_count() == 0)
+        throw std::runtime_error("mesh has no vertices or indices.");
+
+    const void *p_indices = mesh.indices.data();
+    uint32_t index_size = mesh.index_size;
+#ifdef GPU_DRIVEN
+    // indirect draws of different meshes share the bound index type
+    std::vector<uint32_t> wide_indices;
+    if (index_size == 2) {
+        wide_indices.resize(mesh.get_index_count());
+        for (size_t i = 0; i < wide_indices.size(); i++)
+            wide_indices[i] = mesh.get_index(i);
+        p_indices = wide_indices.data();
+        index_size = 4;
+    }
+#endif
+
+    using pos_type = VCW_Layout::pos_type;
+    // the detail levels follow the mesh's own indices, in the same index type
+    VkDeviceSize index_count = mesh.get_index_count();
+    for (const auto &lod: mesh.lods)
+        index_count += lod.indices.size();
+    VkDeviceSize index_bytes = index_size * index_count;
+    // firstIndex counts in indices of the mesh's type, so its range starts at a multiple of the index size
+    VkDeviceSize index_offset = align_up(geo_index_head, index_size);
+
+    // the streams are sized for the same vertex count, checking the first covers all of them
+    if ((geo_vert_head + mesh.vertices.size()) * sizeof(pos_type) > vert_buf.size ||
+        index_offset + index_bytes > index_buf.size)
+        throw std::runtime_error("geometry store is full.");
+
+    VCW_PosDequant dequant = get_pos_dequant(mesh.vertices);
+    std::vector<glm::vec3> normals;
+#ifdef QUANTIZED_VERTICES
+    normals = generate_normals(mesh);
+#endif
+
+#if defined(QUANTIZED_VERTICES) || defined(SPLIT_VERTEX_STREAMS)
+    std::vector<pos_type> pos_stream = pack_stream<pos_type>(mesh, normals, dequant);
+    upload_to_buf(vert_buf, pos_stream.data(), sizeof(pos_type) * pos_stream.size(), geo_vert_head * sizeof(pos_type));
+#else
+    // the default layout is the mesh's own vertex format
+    upload_to_buf(vert_buf, mesh.vertices.data(), mesh.vertices.size_bytes(), geo_vert_head * sizeof(pos_type));
+#endif
+#ifdef SPLIT_VERTEX_STREAMS
+    using attrib_type = VCW_Layout::attrib_type;
+    std::vector<attrib_type> attrib_stream = pack_stream<attrib_type>(mesh, normals, dequant);
+    upload_to_buf(attrib_buf, attrib_stream.data(), sizeof(attrib_type) * attrib_stream.size(),
+                  geo_vert_head * sizeof(attrib_type));
+#endif
+    VCW_MeshRange range{};
+    range.first_index = static_cast<uint32_t>(index_offset / index_size);
+    range.index_count = mesh.get_index_count();
+    range.lods[0] = {range.first_index, range.index_count, 0.0f};
+    range.lod_count = 1;
+    upload_to_buf(index_buf, p_indices, static_cast<VkDeviceSize>(index_size) * range.index_count, index_offset);
+
+    uint32_t lod_first_index = range.first_index + range.index_count;
+    for (const auto &lod: mesh.lods) {
+        if (range.lod_count == LOD_MAX_LEVELS)
+            break;
+        auto lod_index_count = static_cast<uint32_t>(lod.indices.size());
+        if (index_size == 2) {
+            std::vector<uint16_t> narrow(lod.indices.begin(), lod.indices.end());
+            upload_to_buf(index_buf, narrow.data(), sizeof(uint16_t) * lod_index_count, 2ull * lod_first_index);
+        } else {
+            upload_to_buf(index_buf, lod.indices.data(), sizeof(uint32_t) * lod_index_count, 4ull * lod_first_index);
+        }
+        range.lods[range.lod_count++] = {lod_first_index, lod_index_count, lod.error};
+        lod_first_index += lod_index_count;
+    }
+    range.vertex_offset = static_cast<int32_t>(geo_vert_head);
+    range.vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+    range.index_type = index_size == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+    // shader.vert flips y and z before the object transform
+    glm::vec3 min_pos = mesh.vertices[0].pos;
+    glm::vec3 max_pos = mesh.vertices[0].pos;
+    for (const auto &vertex: mesh.vertices) {
+        min_pos = glm::min(min_pos, vertex.pos);
+        max_pos = glm::max(max_pos, vertex.pos);
+    }
+    glm::vec3 center = (min_pos + max_pos) / 2.0f;
+    float radius = 0.0f;
+    for (const auto &vertex: mesh.vertices)
+        radius = std::max(radius, glm::length(vertex.pos - center));
+    range.sphere = glm::vec4(center.x, -center.y, -center.z, radius);
+    range.dequant = dequant;
+
+    // FRONT_FACE is given in framebuffer space, the projection is not y flipped, so clockwise there is
+    // counter clockwise in the mesh's space. clusters are only cone culled if back faces are
+    float cone_sign = FRONT_FACE == VK_FRONT_FACE_CLOCKWISE ? 1.0f : -1.0f;
+    range.first_meshlet = static_cast<uint32_t>(gpu_meshlets.size());
+    for (const auto &meshlet: build_meshlets(mesh)) {
+        VCW_GpuMeshlet gpu_meshlet{};
+        gpu_meshlet.sphere = glm::vec4(meshlet.sphere.x, -meshlet.sphere.y, -meshlet.sphere.z, meshlet.sphere.w);
+        gpu_meshlet.cone = glm::vec4(cone_sign * meshlet.cone.x, -cone_sign * meshlet.cone.y,
+                                     -cone_sign * meshlet.cone.z, meshlet.cone.w);
+        if (!(CULL_MODE & VK_CULL_MODE_BACK_BIT))
+            gpu_meshlet.cone.w = 2.0f;
+        gpu_meshlet.first_index = range.first_index + meshlet.first_triangle * 3;
+        gpu_meshlet.index_count = meshlet.triangle_count * 3;
+        gpu_meshlets.push_back(gpu_meshlet);
+    }
+    range.meshlet_count = static_cast<uint32_t>(gpu_meshlets.size()) - range.first_meshlet;
+
+    geo_vert_head += mesh.vertices.size();
+    geo_index_head = index_offset + index_bytes;
+    meshes.push_back(range);
+
+    return static_cast<uint32_t>(meshes.size() - 1);
+}
+
+// an estimate that ignores the post transform cache, good enough to compare layouts
+VkDeviceSize App::get_vertex_fetch_bytes(uint32_t vertex_size) const {
+    VkDeviceSize bytes = 0;
+    for (size_t i = 0; i < draws.size(); i++) {
+#ifdef INSTANCING
+        VkDeviceSize visible = draws[i].instance_count;
+#else
+        VkDeviceSize visible = scene.visible[i];
+#endif
+        bytes += visible * meshes[draws[i].mesh_index].vertex_count * vertex_size;
+    }
+    return bytes;
+}
+
+// every startup mesh is looked at from MESHLET_BENCH_VIEWS directions around it, the clusters are tested like
+// the culling pass of MESHLETS does and compared with the triangles that actually face away
+void App::bench_meshlets(const std::vector<VCW_Mesh> &loaded_meshes) {
+    for (size_t m = 0; m < loaded_meshes.size(); m++) {
+        const VCW_Mesh &mesh = loaded_meshes[m];
+        const VCW_MeshRange &range = meshes[m];
+        glm::vec3 center(range.sphere);
+        float cone_sign = FRONT_FACE == VK_FRONT_FACE_CLOCKWISE ? 1.0f : -1.0f;
+
+        VCW_MeshletCullStats stats{};
+        for (uint32_t view = 0; view < MESHLET_BENCH_VIEWS; view++) {
+            // fibonacci sphere
+            float y = 1.0f - 2.0f * (static_cast<float>(view) + 0.5f) / MESHLET_BENCH_VIEWS;
+            float phi = static_cast<float>(view) * 2.39996323f;
+            glm::vec3 dir(std::cos(phi) * std::sqrt(1.0f - y * y), y, std::sin(phi) * std::sqrt(1.0f - y * y));
+
+            VCW_Camera view_cam{};
+            view_cam.create_default_cam(render_extent);
+            view_cam.pos = center + dir * range.sphere.w * MESHLET_BENCH_DISTANCE;
+            view_cam.yaw = glm::degrees(std::atan2(-dir.z, -dir.x));
+            view_cam.pitch = glm::degrees(std::asin(-dir.y));
+            view_cam.update_cam_rotation(0.0f, 0.0f);
+            std::array<glm::vec4, 6> planes = view_cam.get_frustum_planes();
+
+            for (uint32_t i = range.first_meshlet; i < range.first_meshlet + range.meshlet_count; i++) {
+                const VCW_GpuMeshlet &meshlet = gpu_meshlets[i];
+                stats.meshlet_count++;
+                stats.triangle_count += meshlet.index_count / 3;
+                if (is_cluster_culled(meshlet.sphere, meshlet.cone, planes, view_cam.pos, &stats))
+                    stats.triangles_culled += meshlet.index_count / 3;
+            }
+
+            // positions as shader.vert sees them
+            auto get_pos = [&](uint32_t i) {
+                glm::vec3 pos = mesh.vertices[mesh.get_index(i)].pos;
+                return glm::vec3(pos.x, -pos.y, -pos.z);
+            };
+            for (uint32_t i = 0; i + 2 < mesh.get_index_count(); i += 3) {
+                glm::vec3 a = get_pos(i);
+                glm::vec3 n = glm::cross(get_pos(i + 1) - a, get_pos(i + 2) - a) * cone_sign;
+                stats.back_facing += glm::dot(n, a - view_cam.pos) >= 0.0f;
+            }
+        }
+
+        auto percent = [](uint64_t part, uint64_t whole) {
+            return 100.0 * static_cast<double>(part) / static_cast<double>(std::max<uint64_t>(1, whole));
+        };
+        std::cout << "meshlets of mesh " << m << ": " << range.meshlet_count << " clusters of "
+                  << static_cast<double>(range.index_count / 3) / std::max(1u, range.meshlet_count)
+                  << " triangles on average, " << percent(stats.frustum_culled, stats.meshlet_count)
+                  << "% frustum and " << percent(stats.cone_culled, stats.meshlet_count) << "% cone culled, "
+                  << percent(stats.triangles_culled, stats.triangle_count) << "% of the triangles culled ("
+                  << percent(stats.back_facing, stats.triangle_count) << "% face away)" << std::endl;
+    }
+}
+
+void App::clean_up_geometry_store() {
+    clean_up_buf(vert_buf);
+#ifdef SPLIT_VERTEX_STREAMS
+    clean_up_buf(attrib_buf);
+#endif
+    clean_up_buf(index_buf);
+}
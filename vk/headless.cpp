@@ -0,0 +1,271 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "../app.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+
+#include <stb_image_write.h>
+
+void App::create_headless_targets() {
+    swap_img_format = HEADLESS_FORMAT;
+    swap_extent = {INITIAL_WIDTH, INITIAL_HEIGHT};
+    render_extent = swap_extent;
+}
+
+void App::create_readback_buf() {
+    readback_frame_size = static_cast<VkDeviceSize>(swap_extent.width) * swap_extent.height * 4;
+
+    // cached memory makes the cpu reads of the frames a lot faster where it exists
+    readback_buf = create_buf(readback_frame_size * frames_in_flight, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                              VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+    map_buf(&readback_buf);
+
+    readback_frames.assign(frames_in_flight, UINT32_MAX);
+}
+
+// the timeline value of the slot has to be reached
+void App::write_frame(uint32_t slot) {
+    if (frame_out_dir.empty() || readback_frames[slot] == UINT32_MAX)
+        return;
+
+    char name[32];
+    snprintf(name, sizeof(name), "/frame_%05u.%s", readback_frames[slot], frame_out_raw ? "rgba" : "png");
+    std::string path = frame_out_dir + name;
+
+    const char *p_pixels = static_cast<const char *>(readback_buf.p_mapped_mem) + slot * readback_frame_size;
+
+    if (frame_out_raw) {
+        std::ofstream file(path, std::ios::binary);
+        if (!file.is_open())
+            throw std::runtime_error("failed to open frame output file.");
+
+        file.write(p_pixels, static_cast<std::streamsize>(readback_frame_size));
+    } else {
+        int width = static_cast<int>(swap_extent.width);
+        int height = static_cast<int>(swap_extent.height);
+
+        if (!stbi_write_png(path.c_str(), width, height, 4, p_pixels, width * 4))
+            throw std::runtime_error("failed to write frame image.");
+    }
+
+    readback_frames[slot] = UINT32_MAX;
+}
+
+void App::render_headless() {
+    wait_gfx_timeline(frame_timeline_values[cur_frame]);
+
+    // the previous frame of this slot is done, its timestamps and pixels can be read
+    if (frame_timeline_values[cur_frame] > 0)
+        fetch_queries(cur_frame);
+    write_frame(cur_frame);
+
+    flush_deletions();
+    reset_frame_desc_pools(cur_frame);
+#ifdef ENABLE_DYNAMIC_UNIFORM
+    reset_dyn_unif_ring(cur_frame);
+#endif
+
+    update_bufs(cur_frame);
+
+    retire_uploads();
+    update_tex_streaming();
+    flush_uploads();
+    write_frame_desc_set(cur_frame);
+
+    reset_frame_cmd_pools(cur_frame);
+    auto record_start_time = std::chrono::high_resolution_clock::now();
+    record_cmd_buf(cmd_bufs[cur_frame], cur_frame);
+    auto record_end_time = std::chrono::high_resolution_clock::now();
+    stats.record_time = std::chrono::duration<double, std::milli>(record_end_time - record_start_time).count();
+
+    uint64_t signal_value = ++gfx_timeline_value;
+
+    VkTimelineSemaphoreSubmitInfo timeline_submit{};
+    timeline_submit.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_submit.signalSemaphoreValueCount = 1;
+    timeline_submit.pSignalSemaphoreValues = &signal_value;
+
+    VkSubmitInfo submit{};
+    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit.pNext = &timeline_submit;
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &cmd_bufs[cur_frame];
+    submit.signalSemaphoreCount = 1;
+    submit.pSignalSemaphores = &gfx_timeline;
+
+    if (vkQueueSubmit(q_graph, 1, &submit, VK_NULL_HANDLE) != VK_SUCCESS)
+        throw std::runtime_error("failed to submit render command buffer.");
+
+    frame_timeline_values[cur_frame] = signal_value;
+    readback_frames[cur_frame] = stats.frame_count;
+
+    cur_frame = (cur_frame + 1) % frames_in_flight;
+}
+
+void App::headless_loop() {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    double gpu_frame_time_sum = 0.0;
+    double record_time_sum = 0.0;
+    double triangle_sum = 0.0;
+
+    while (stats.frame_count < headless_frame_count) {
+        auto frame_start_time = std::chrono::high_resolution_clock::now();
+        render_headless();
+        auto frame_end_time = std::chrono::high_resolution_clock::now();
+        auto render_duration = std::chrono::duration_cast<std::chrono::microseconds>(frame_end_time - frame_start_time);
+
+        stats.frame_time += (float) render_duration.count() / 1000.0f;
+        stats.frame_time /= 2.0f;
+        gpu_frame_time_sum += stats.gpu_frame_time;
+        record_time_sum += stats.record_time;
+        triangle_sum += static_cast<double>(stats.triangles);
+
+        stats.frame_count++;
+    }
+
+    vkDeviceWaitIdle(dev);
+
+    for (uint32_t i = 0; i < frames_in_flight; i++)
+        write_frame(i);
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end_time - start_time).count();
+
+    std::cout << "rendered " << stats.frame_count << " frames (" << swap_extent.width << "x" << swap_extent.height
+              << ") in " << seconds << "s, " << (double) stats.frame_count / seconds << " frames/s" << std::endl;
+    std::cout << "cpu frame time: " << stats.frame_time << "ms, avg gpu frame time: "
+              << gpu_frame_time_sum / std::max(1u, stats.frame_count) << "ms" << std::endl;
+    std::cout << "avg record time: " << record_time_sum / std::max(1u, stats.frame_count) << "ms (" << draws.size()
+              << " draws, " << scene.visible_count << "/" << scene.size() << " objects visible, "
+              << triangle_sum / std::max(1u, stats.frame_count) << " triangles per frame)" << std::endl;
+
+    // vertex bytes of the last frame's visible objects, against the original interleaved float layout
+    double avg_gpu_frame_time = gpu_frame_time_sum / std::max(1u, stats.frame_count);
+    double fetch_bytes = static_cast<double>(get_vertex_fetch_bytes(VCW_Layout::get_vertex_size()));
+    std::cout << "vertex fetch: " << fetch_bytes / 1048576.0 << " MiB per frame ("
+              << static_cast<double>(get_vertex_fetch_bytes(sizeof(Vertex))) / 1048576.0
+              << " MiB as float position + uv), " << VCW_Layout::get_vertex_size() << " B per vertex";
+    if (avg_gpu_frame_time > 0.0)
+        std::cout << ", " << fetch_bytes / (avg_gpu_frame_time * 1e6) << " GB/s";
+    std::cout << std::endl;
+
+    if (!stream_texs.empty())
+        std::cout << "texture streaming: " << stream_stats.resident_count << "/" << stream_texs.size()
+                  << " resident, " << stream_stats.resident_bytes / 1048576 << " MiB (wanted "
+                  << stream_stats.wanted_bytes / 1048576 << ", budget " << tex_budget / 1048576 << "), "
+                  << stream_stats.promotions << " promotions, " << stream_stats.evictions << " evictions" << std::endl;
+}
+
+// the camera moves back until the whole scene lies in front of it, the same frames are then rendered
+// with every mesh in full and with detail levels
+void App::lod_bench_loop() {
+    float depth = 0.0f;
+    for (size_t i = 0; i < scene.size(); i++)
+        depth = std::max(depth, scene.center_z[i] + scene.radius[i]);
+    cam.pos = glm::vec3(0.0f, 0.0f, depth + LOD_BENCH_DISTANCE);
+
+    uint32_t warm_up = std::min(frames_in_flight, headless_frame_count - 1);
+    for (bool use_lods: {false, true}) {
+        vkDeviceWaitIdle(dev);
+        lods = use_lods;
+
+        double gpu_frame_time_sum = 0.0;
+        double triangle_sum = 0.0;
+        for (uint32_t frame = 0; frame < headless_frame_count; frame++) {
+            render_headless();
+            stats.frame_count++;
+
+            // gpu times arrive frames_in_flight frames late
+            if (frame < warm_up)
+                continue;
+            gpu_frame_time_sum += stats.gpu_frame_time;
+            triangle_sum += static_cast<double>(stats.triangles);
+        }
+
+        double measured = std::max(1u, headless_frame_count - warm_up);
+        std::cout << (use_lods ? "lods on: " : "lods off: ") << triangle_sum / measured << " triangles per frame ("
+                  << scene.visible_count << "/" << scene.size() << " objects visible), gpu frame time "
+                  << gpu_frame_time_sum / measured << "ms" << std::endl;
+    }
+
+    vkDeviceWaitIdle(dev);
+}
+
+// the texture view stays the same, only the sampler switches between the full chain and its base level
+void App::mip_bench_loop() {
+    bench_mip_generation();
+
+    VCW_Image base_img = tex_img;
+    base_img.mip_levels = 1;
+    create_sampler(&base_img, VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT);
+    VkSampler mip_sampler = tex_img.sampler;
+
+    uint32_t warm_up = std::min(frames_in_flight, headless_frame_count - 1);
+    for (bool use_mips: {false, true}) {
+        vkDeviceWaitIdle(dev);
+        tex_img.sampler = use_mips ? mip_sampler : base_img.sampler;
+#ifdef BINDLESS
+        write_img_desc_binding({tex_img.sampler, tex_img.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+                               bindless_set, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, tex_bindless_index);
+#endif
+
+        double gpu_frame_time_sum = 0.0;
+        for (uint32_t frame = 0; frame < headless_frame_count; frame++) {
+            render_headless();
+            stats.frame_count++;
+
+            // gpu times arrive frames_in_flight frames late
+            if (frame < warm_up)
+                continue;
+            gpu_frame_time_sum += stats.gpu_frame_time;
+        }
+
+        double measured = std::max(1u, headless_frame_count - warm_up);
+        std::cout << (use_mips ? "mips on: " : "mips off: ") << (use_mips ? tex_img.mip_levels : 1)
+                  << " levels sampled, gpu frame time " << gpu_frame_time_sum / measured << "ms" << std::endl;
+    }
+
+    vkDeviceWaitIdle(dev);
+    vkDestroySampler(dev, base_img.sampler, nullptr);
+}
+
+// doubles the object count up to stress_max, every step renders headless_frame_count frames
+void App::stress_loop() {
+    for (uint32_t count = std::min(STRESS_MIN_OBJECTS, stress_max);; count = std::min(count * 2, stress_max)) {
+        vkDeviceWaitIdle(dev);
+        set_object_count(count);
+
+        // gpu times arrive frames_in_flight frames late, the first ones still belong to the previous step
+        uint32_t warm_up = std::min(frames_in_flight, headless_frame_count - 1);
+        double frame_time_sum = 0.0;
+        double gpu_frame_time_sum = 0.0;
+        double record_time_sum = 0.0;
+
+        for (uint32_t frame = 0; frame < headless_frame_count; frame++) {
+            auto frame_start_time = std::chrono::high_resolution_clock::now();
+            render_headless();
+            auto frame_end_time = std::chrono::high_resolution_clock::now();
+            stats.frame_count++;
+
+            if (frame < warm_up)
+                continue;
+
+            frame_time_sum += std::chrono::duration<double, std::milli>(frame_end_time - frame_start_time).count();
+            gpu_frame_time_sum += stats.gpu_frame_time;
+            record_time_sum += stats.record_time;
+        }
+
+        double measured = std::max(1u, headless_frame_count - warm_up);
+        std::cout << "objects " << count << " (" << draws.size() << " draws): cpu frame time "
+                  << frame_time_sum / measured << "ms, gpu frame time " << gpu_frame_time_sum / measured
+                  << "ms, record time " << record_time_sum / measured << "ms" << std::endl;
+
+        if (count >= stress_max)
+            break;
+    }
+
+    vkDeviceWaitIdle(dev);
+}
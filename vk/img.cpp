@@ -32,20 +32,27 @@ bool App::has_stencil_component(VkFormat format) {
 }
 
 VCW_Image App::create_img(VkExtent2D extent, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-                          VkMemoryPropertyFlags mem_props) {
+                          VkMemoryPropertyFlags mem_props, uint32_t mip_levels, uint32_t array_layers,
+                          VkImageCreateFlags flags) {
     VCW_Image img;
     img.format = format;
     img.cur_layout = VK_IMAGE_LAYOUT_UNDEFINED;
     img.extent.width = extent.width;
     img.extent.height = extent.height;
     img.extent.depth = 1;
+    img.mip_levels = mip_levels;
+    img.array_layers = array_layers;
+    // the usage the format itself does not support is only used through views of another format
+    if (flags & VK_IMAGE_CREATE_EXTENDED_USAGE_BIT)
+        img.view_usage = usage & ~VK_IMAGE_USAGE_STORAGE_BIT;
 
     VkImageCreateInfo img_info{};
     img_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    img_info.flags = flags;
     img_info.imageType = VK_IMAGE_TYPE_2D;
     img_info.extent = img.extent;
-    img_info.mipLevels = 1;
-    img_info.arrayLayers = 1;
+    img_info.mipLevels = img.mip_levels;
+    img_info.arrayLayers = img.array_layers;
     img_info.format = img.format;
     img_info.tiling = tiling;
     img_info.initialLayout = img.cur_layout;
@@ -59,15 +66,10 @@ VCW_Image App::create_img(VkExtent2D extent, VkFormat format, VkImageTiling tili
     VkMemoryRequirements mem_reqs;
     vkGetImageMemoryRequirements(dev, img.img, &mem_reqs);
 
-    VkMemoryAllocateInfo alloc_info{};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_reqs.size;
-    alloc_info.memoryTypeIndex = find_mem_type(mem_reqs.memoryTypeBits, mem_props);
+    img.alloc = alloc_mem(mem_reqs, mem_props, 0, tiling == VK_IMAGE_TILING_LINEAR);
 
-    if (vkAllocateMemory(dev, &alloc_info, nullptr, &img.mem) != VK_SUCCESS)
-        throw std::runtime_error("failed to allocate image memory.");
-
-    vkBindImageMemory(dev, img.img, img.mem, 0);
+    if (vkBindImageMemory(dev, img.img, img.alloc.mem, img.alloc.offset) != VK_SUCCESS)
+        throw std::runtime_error("failed to bind image memory.");
 
     return img;
 }
@@ -76,11 +78,17 @@ void App::create_img_view(VCW_Image *p_img, VkImageAspectFlags aspect_flags) {
     VkImageViewCreateInfo view_info{};
     view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     view_info.image = p_img->img;
-    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.viewType = p_img->array_layers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
     view_info.format = p_img->format;
-    view_info.subresourceRange = DEFAULT_SUBRESOURCE_RANGE;
+    view_info.subresourceRange = get_subresource_range(*p_img);
     view_info.subresourceRange.aspectMask = aspect_flags;
 
+    VkImageViewUsageCreateInfo usage_info{};
+    usage_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO;
+    usage_info.usage = p_img->view_usage;
+    if (p_img->view_usage)
+        view_info.pNext = &usage_info;
+
     if (vkCreateImageView(dev, &view_info, nullptr, &p_img->view) != VK_SUCCESS)
         throw std::runtime_error("failed to create image view.");
 }
@@ -102,6 +110,10 @@ void App::create_sampler(VCW_Image *p_img, VkFilter filter, VkSamplerAddressMode
     sampler_info.compareEnable = VK_FALSE;
     sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
     sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sampler_info.minLod = 0.0f;
+    // a single level image is never sampled past its base, even through a view of a longer chain
+    sampler_info.maxLod = static_cast<float>(p_img->mip_levels - 1);
+    sampler_info.mipLodBias = 0.0f;
 
     if (vkCreateSampler(dev, &sampler_info, nullptr, &p_img->sampler) != VK_SUCCESS)
         throw std::runtime_error("failed to create sampler.");
@@ -140,31 +152,64 @@ VkAccessFlags App::get_access_mask(VkImageLayout layout) {
     }
 }
 
+// all mip levels and array layers
+VkImageSubresourceRange App::get_subresource_range(const VCW_Image &img) {
+    VkImageSubresourceRange range = DEFAULT_SUBRESOURCE_RANGE;
+    range.levelCount = img.mip_levels;
+    range.layerCount = img.array_layers;
+
+    return range;
+}
+
 void App::transition_img_layout(VkCommandBuffer cmd_buf, VCW_Image *p_img, VkImageLayout layout,
                                 VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage) {
+    transition_img_subresource(cmd_buf, p_img, get_subresource_range(*p_img), p_img->cur_layout, layout, src_stage,
+                               dst_stage);
+
+    p_img->cur_layout = layout;
+}
+
+// cur_layout is not touched, the caller tracks layouts that differ between subresources
+void App::transition_img_subresource(VkCommandBuffer cmd_buf, VCW_Image *p_img, const VkImageSubresourceRange &range,
+                                     VkImageLayout old_layout, VkImageLayout new_layout,
+                                     VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage) {
     VkImageMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = p_img->cur_layout;
-    barrier.newLayout = layout;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
     barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.image = p_img->img;
-    barrier.subresourceRange = DEFAULT_SUBRESOURCE_RANGE;
+    barrier.subresourceRange = range;
 
-    barrier.srcAccessMask = get_access_mask(p_img->cur_layout);
-    barrier.dstAccessMask = get_access_mask(layout);
+    barrier.srcAccessMask = get_access_mask(old_layout);
+    barrier.dstAccessMask = get_access_mask(new_layout);
 
     vkCmdPipelineBarrier(cmd_buf, src_stage, dst_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
 
-    p_img->cur_layout = layout;
+void App::cp_img_to_buf(VkCommandBuffer cmd_buf, VCW_Image img, VCW_Buffer buf, VkDeviceSize buf_offset) {
+    VkBufferImageCopy region{};
+    region.bufferOffset = buf_offset;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource = DEFAULT_SUBRESOURCE_LAYERS;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = img.extent;
+
+    vkCmdCopyImageToBuffer(cmd_buf, img.img, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buf.buf, 1, &region);
 }
 
-void App::cp_buf_to_img(VkCommandBuffer cmd_buf, VCW_Buffer buf, VCW_Image img, VkExtent2D extent) {
+void App::cp_buf_to_img(VkCommandBuffer cmd_buf, VCW_Buffer buf, VCW_Image img, VkExtent2D extent,
+                        VkDeviceSize buf_offset, uint32_t mip_level) {
     VkBufferImageCopy region{};
-    region.bufferOffset = 0;
+    region.bufferOffset = buf_offset;
     region.bufferRowLength = 0;
     region.bufferImageHeight = 0;
     region.imageSubresource = DEFAULT_SUBRESOURCE_LAYERS;
+    // layers are tightly packed one after another in the buffer
+    region.imageSubresource.mipLevel = mip_level;
+    region.imageSubresource.layerCount = img.array_layers;
     region.imageOffset = {0, 0, 0};
     region.imageExtent.width = extent.width;
     region.imageExtent.height = extent.height;
@@ -203,6 +248,342 @@ void App::copy_img(VkCommandBuffer cmd_buf, VCW_Image src, VCW_Image dst) {
                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
 }
 
+uint32_t App::get_mip_count(VkExtent2D extent) {
+    return static_cast<uint32_t>(std::bit_width(std::max(extent.width, extent.height)));
+}
+
+bool App::supports_mip_blit(VkFormat format) {
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(phy_dev, format, &props);
+
+    VkFormatFeatureFlags blit_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                         VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (props.optimalTilingFeatures & blit_features) == blit_features;
+}
+
+bool App::supports_mip_compute(VkFormat format) {
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(phy_dev, format, &props);
+
+    // srgb levels are written through a unorm view and encoded in mip.comp
+    VkFormatProperties storage_props;
+    vkGetPhysicalDeviceFormatProperties(phy_dev, get_linear_format(format), &storage_props);
+
+    return storage_write_without_format && (props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) &&
+           (storage_props.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT);
+}
+
+// usage the image needs for generate_mips, 0 if the format supports neither path
+VkImageUsageFlags App::get_mip_gen_usage(VkFormat format) {
+    if (supports_mip_blit(format))
+        return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+    if (supports_mip_compute(format))
+        return VK_IMAGE_USAGE_STORAGE_BIT;
+
+    return 0;
+}
+
+// create flags for the usage of get_mip_gen_usage
+VkImageCreateFlags App::get_mip_gen_flags(VkFormat format) {
+    if (get_mip_gen_usage(format) != VK_IMAGE_USAGE_STORAGE_BIT || get_linear_format(format) == format)
+        return 0;
+
+    return VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+}
+
+//
+// fills mip levels 1.. from level 0, every subresource has to be in TRANSFER_DST_OPTIMAL
+// and ends up in SHADER_READ_ONLY_OPTIMAL, needs a queue with graphics support
+//
+void App::generate_mips(VkCommandBuffer cmd_buf, VCW_Image *p_img) {
+    if (get_mip_gen_usage(p_img->format) == VK_IMAGE_USAGE_TRANSFER_SRC_BIT)
+        generate_mips_blit(cmd_buf, p_img);
+    else
+        generate_mips_compute(cmd_buf, p_img);
+
+    p_img->cur_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+void App::generate_mips_blit(VkCommandBuffer cmd_buf, VCW_Image *p_img) {
+    VkImageSubresourceRange range = get_subresource_range(*p_img);
+    range.levelCount = 1;
+
+    int32_t width = static_cast<int32_t>(p_img->extent.width);
+    int32_t height = static_cast<int32_t>(p_img->extent.height);
+
+    for (uint32_t level = 1; level < p_img->mip_levels; level++) {
+        range.baseMipLevel = level - 1;
+        transition_img_subresource(cmd_buf, p_img, range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                   VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+        int32_t next_width = std::max(width / 2, 1);
+        int32_t next_height = std::max(height / 2, 1);
+
+        VkImageBlit region{};
+        region.srcSubresource = DEFAULT_SUBRESOURCE_LAYERS;
+        region.srcSubresource.mipLevel = level - 1;
+        region.srcSubresource.layerCount = p_img->array_layers;
+        region.srcOffsets[0] = {0, 0, 0};
+        region.srcOffsets[1] = {width, height, 1};
+        region.dstSubresource = region.srcSubresource;
+        region.dstSubresource.mipLevel = level;
+        region.dstOffsets[0] = {0, 0, 0};
+        region.dstOffsets[1] = {next_width, next_height, 1};
+
+        vkCmdBlitImage(cmd_buf, p_img->img, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, p_img->img,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_LINEAR);
+
+        transition_img_subresource(cmd_buf, p_img, range, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+        width = next_width;
+        height = next_height;
+    }
+
+    range.baseMipLevel = p_img->mip_levels - 1;
+    transition_img_subresource(cmd_buf, p_img, range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                               VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+//
+// for formats without linear filtered blits, each level is a 2x2 box filter of the previous one,
+// the per level views and descriptors belong to the upload batch and are destroyed once it retired
+//
+void App::generate_mips_compute(VkCommandBuffer cmd_buf, VCW_Image *p_img) {
+    if (mip_pipe == VK_NULL_HANDLE)
+        create_mip_pipe();
+
+    uint32_t level_count = p_img->mip_levels - 1;
+
+    std::array<VkDescriptorPoolSize, 2> pool_sizes{};
+    pool_sizes[0] = {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, level_count};
+    pool_sizes[1] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, level_count};
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets = level_count;
+    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+    pool_info.pPoolSizes = pool_sizes.data();
+
+    VkDescriptorPool mip_desc_pool;
+    if (vkCreateDescriptorPool(dev, &pool_info, nullptr, &mip_desc_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create mip descriptor pool.");
+    upload_batch.tmp_desc_pools.push_back(mip_desc_pool);
+
+    std::vector<VkDescriptorSetLayout> set_layouts(level_count, mip_desc_set_layout);
+    std::vector<VkDescriptorSet> sets(level_count);
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = mip_desc_pool;
+    alloc_info.descriptorSetCount = level_count;
+    alloc_info.pSetLayouts = set_layouts.data();
+
+    if (vkAllocateDescriptorSets(dev, &alloc_info, sets.data()) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate mip descriptor sets.");
+
+    // sources are read through the image's format, so srgb is decoded by the hardware, destinations are written
+    // through the unorm format of the same bits and encoded by the shader
+    VkFormat storage_format = get_linear_format(p_img->format);
+    auto create_level_view = [&](uint32_t level, VkFormat format, VkImageUsageFlags usage) {
+        VkImageViewUsageCreateInfo usage_info{};
+        usage_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO;
+        usage_info.usage = usage;
+
+        VkImageViewCreateInfo view_info{};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.pNext = storage_format != p_img->format ? &usage_info : nullptr;
+        view_info.image = p_img->img;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        view_info.format = format;
+        view_info.subresourceRange = get_subresource_range(*p_img);
+        view_info.subresourceRange.baseMipLevel = level;
+        view_info.subresourceRange.levelCount = 1;
+
+        VkImageView view;
+        if (vkCreateImageView(dev, &view_info, nullptr, &view) != VK_SUCCESS)
+            throw std::runtime_error("failed to create mip level view.");
+        upload_batch.tmp_views.push_back(view);
+        return view;
+    };
+
+    // all level sets are written in one call
+    for (uint32_t level = 1; level < p_img->mip_levels; level++) {
+        VkImageView src_view = create_level_view(level - 1, p_img->format, VK_IMAGE_USAGE_SAMPLED_BIT);
+        VkImageView dst_view = create_level_view(level, storage_format, VK_IMAGE_USAGE_STORAGE_BIT);
+
+        write_img_desc_binding({VK_NULL_HANDLE, src_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+                               sets[level - 1], 0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
+        write_img_desc_binding({VK_NULL_HANDLE, dst_view, VK_IMAGE_LAYOUT_GENERAL}, sets[level - 1], 1,
+                               VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+    }
+    flush_desc_writes();
+
+    uint32_t encode_srgb = storage_format != p_img->format;
+
+    VkImageSubresourceRange range = get_subresource_range(*p_img);
+    range.levelCount = 1;
+
+    // level 0 is the first source
+    transition_img_subresource(cmd_buf, p_img, range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_COMPUTE, mip_pipe);
+    vkCmdPushConstants(cmd_buf, mip_pipe_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(encode_srgb), &encode_srgb);
+
+    for (uint32_t level = 1; level < p_img->mip_levels; level++) {
+        range.baseMipLevel = level;
+        transition_img_subresource(cmd_buf, p_img, range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                   VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+        vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_COMPUTE, mip_pipe_layout, 0, 1, &sets[level - 1],
+                                0, nullptr);
+
+        uint32_t width = std::max(p_img->extent.width >> level, 1u);
+        uint32_t height = std::max(p_img->extent.height >> level, 1u);
+        vkCmdDispatch(cmd_buf, (width + 7) / 8, (height + 7) / 8, p_img->array_layers);
+
+        transition_img_subresource(cmd_buf, p_img, range, VK_IMAGE_LAYOUT_GENERAL,
+                                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                   VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    }
+}
+
+//
+// times both generation paths on a scratch image shaped like the sample texture, the base level content
+// does not change the work, so it is left undefined
+//
+void App::bench_mip_generation() {
+    VkExtent2D extent = {tex_img.extent.width, tex_img.extent.height};
+    uint32_t mip_levels = get_mip_count(extent);
+    bool blit = supports_mip_blit(tex_img.format);
+    bool compute = supports_mip_compute(tex_img.format);
+    if (mip_levels == 1 || (!blit && !compute)) {
+        std::cout << "mip generation: not supported for format " << tex_img.format << std::endl;
+        return;
+    }
+
+    VCW_Image scratch = create_img(extent, tex_img.format, VK_IMAGE_TILING_OPTIMAL,
+                                   VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+                                   (blit ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0) |
+                                   (compute ? VK_IMAGE_USAGE_STORAGE_BIT : 0),
+                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mip_levels, tex_img.array_layers,
+                                   compute && get_linear_format(tex_img.format) != tex_img.format
+                                   ? VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT : 0);
+    scratch.view = VK_NULL_HANDLE;
+
+    VkQueryPoolCreateInfo query_pool_info{};
+    query_pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    query_pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    query_pool_info.queryCount = 2;
+
+    VkQueryPool mip_query_pool;
+    if (vkCreateQueryPool(dev, &query_pool_info, nullptr, &mip_query_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create mip query pool.");
+
+    std::cout << "mip generation: " << extent.width << "x" << extent.height << ", " << mip_levels << " levels";
+    for (bool use_compute: {false, true}) {
+        if (use_compute ? !compute : !blit)
+            continue;
+
+        double time_sum = 0.0;
+        for (uint32_t i = 0; i < MIP_BENCH_ITERATIONS; i++) {
+            VkCommandBuffer cmd_buf = begin_single_time_cmd();
+            vkCmdResetQueryPool(cmd_buf, mip_query_pool, 0, 2);
+            transition_img_layout(cmd_buf, &scratch, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                  VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+            end_single_time_cmd(cmd_buf);
+
+            // the compute path hands its level views to the upload batch, they are released here instead
+            size_t view_count = upload_batch.tmp_views.size();
+            size_t desc_pool_count = upload_batch.tmp_desc_pools.size();
+
+            cmd_buf = begin_single_time_cmd();
+            vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mip_query_pool, 0);
+            if (use_compute)
+                generate_mips_compute(cmd_buf, &scratch);
+            else
+                generate_mips_blit(cmd_buf, &scratch);
+            vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mip_query_pool, 1);
+            end_single_time_cmd(cmd_buf);
+            scratch.cur_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+            for (size_t v = view_count; v < upload_batch.tmp_views.size(); v++)
+                vkDestroyImageView(dev, upload_batch.tmp_views[v], nullptr);
+            upload_batch.tmp_views.resize(view_count);
+            for (size_t p = desc_pool_count; p < upload_batch.tmp_desc_pools.size(); p++)
+                vkDestroyDescriptorPool(dev, upload_batch.tmp_desc_pools[p], nullptr);
+            upload_batch.tmp_desc_pools.resize(desc_pool_count);
+
+            uint64_t timestamps[2];
+            if (vkGetQueryPoolResults(dev, mip_query_pool, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t),
+                                      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+                throw std::runtime_error("failed to read mip query results.");
+            time_sum += (double) (timestamps[1] - timestamps[0]) * phy_dev_props.limits.timestampPeriod / 1000000.0;
+        }
+
+        std::cout << (use_compute ? ", compute " : ", blit ") << time_sum / MIP_BENCH_ITERATIONS << "ms";
+    }
+    std::cout << std::endl;
+
+    vkDestroyQueryPool(dev, mip_query_pool, nullptr);
+    clean_up_img(scratch);
+}
+
+void App::create_mip_pipe() {
+    std::vector<VkDescriptorSetLayoutBinding> bindings(2);
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1] = bindings[0];
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+
+    mip_desc_set_layout = get_desc_set_layout(bindings);
+
+    VkPipelineLayoutCreateInfo pipe_layout_info{};
+    pipe_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipe_layout_info.setLayoutCount = 1;
+    pipe_layout_info.pSetLayouts = &mip_desc_set_layout;
+
+    VkPushConstantRange push_range{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t)};
+    pipe_layout_info.pushConstantRangeCount = 1;
+    pipe_layout_info.pPushConstantRanges = &push_range;
+
+    if (vkCreatePipelineLayout(dev, &pipe_layout_info, nullptr, &mip_pipe_layout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create mip pipeline layout.");
+
+    VkShaderModule comp_module = create_shader_mod(read_file("mip.spv"));
+
+    VkComputePipelineCreateInfo pipe_info{};
+    pipe_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipe_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipe_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipe_info.stage.module = comp_module;
+    pipe_info.stage.pName = "main";
+    pipe_info.layout = mip_pipe_layout;
+
+    if (vkCreateComputePipelines(dev, pipe_cache, 1, &pipe_info, nullptr, &mip_pipe) != VK_SUCCESS)
+        throw std::runtime_error("failed to create mip pipeline.");
+
+    vkDestroyShaderModule(dev, comp_module, nullptr);
+}
+
+void App::clean_up_mip_pipe() {
+    if (mip_pipe == VK_NULL_HANDLE)
+        return;
+
+    vkDestroyPipeline(dev, mip_pipe, nullptr);
+    vkDestroyPipelineLayout(dev, mip_pipe_layout, nullptr);
+}
+
 void App::clean_up_img(VCW_Image img) {
     if (img.has_sampler)
         vkDestroySampler(dev, img.sampler, nullptr);
@@ -210,5 +591,5 @@ void App::clean_up_img(VCW_Image img) {
     vkDestroyImageView(dev, img.view, nullptr);
 
     vkDestroyImage(dev, img.img, nullptr);
-    vkFreeMemory(dev, img.mem, nullptr);
+    free_mem(img.alloc);
 }
\ No newline at end of file
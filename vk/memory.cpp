@@ -0,0 +1,353 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "../app.h"
+
+// higher is better and may be negative, empty if the type can not be used
+std::optional<int> App::score_mem_type(VkMemoryPropertyFlags flags, VkMemoryPropertyFlags required,
+                                       VkMemoryPropertyFlags preferred) {
+    if ((flags & required) != required)
+        return std::nullopt;
+
+    // never hand out protected, lazily allocated or amd device coherent memory unless asked for
+    VkMemoryPropertyFlags exotic = VK_MEMORY_PROPERTY_PROTECTED_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT |
+                                   VK_MEMORY_PROPERTY_DEVICE_COHERENT_BIT_AMD;
+    if (flags & exotic & ~(required | preferred))
+        return std::nullopt;
+
+    // every preferred flag outweighs all flags nobody asked for
+    return std::popcount(flags & preferred) * 32 - std::popcount(flags & ~(required | preferred));
+}
+
+void App::build_mem_type_lut() {
+    mem_type_lut.clear();
+
+    uma = phy_dev_props.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ||
+          phy_dev_props.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+    static_pref_mem_props = uma ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : 0;
+
+    // warm up the combinations used by the app, most drivers report every type as compatible for buffers
+    uint32_t all_types = phy_dev_mem_props.memoryTypeCount >= 32 ? ~0u
+                                                                 : (1u << phy_dev_mem_props.memoryTypeCount) - 1;
+
+    resolve_mem_type(all_types, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+    resolve_mem_type(all_types, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, static_pref_mem_props);
+    resolve_mem_type(all_types, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0);
+    resolve_mem_type(all_types, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                     VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+}
+
+int App::resolve_mem_type(uint32_t type_filter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) {
+    uint64_t key = (uint64_t) type_filter | (uint64_t) (required & 0xFFFF) << 32 |
+                   (uint64_t) (preferred & 0xFFFF) << 48;
+
+    auto it = mem_type_lut.find(key);
+    if (it != mem_type_lut.end())
+        return static_cast<int>(it->second);
+
+    int best_type = -1;
+    int best_score = 0;
+
+    for (uint32_t i = 0; i < phy_dev_mem_props.memoryTypeCount; i++) {
+        if (!(type_filter & (1u << i)))
+            continue;
+
+        const VkMemoryType &type = phy_dev_mem_props.memoryTypes[i];
+        std::optional<int> score = score_mem_type(type.propertyFlags, required, preferred);
+        if (!score)
+            continue;
+
+        // on a tie the larger heap wins
+        bool larger_heap = false;
+        if (best_type >= 0 && *score == best_score) {
+            uint32_t best_heap = phy_dev_mem_props.memoryTypes[best_type].heapIndex;
+            larger_heap = phy_dev_mem_props.memoryHeaps[type.heapIndex].size >
+                          phy_dev_mem_props.memoryHeaps[best_heap].size;
+        }
+
+        if (best_type < 0 || *score > best_score || larger_heap) {
+            best_type = static_cast<int>(i);
+            best_score = *score;
+        }
+    }
+
+    if (best_type >= 0)
+        mem_type_lut[key] = static_cast<uint32_t>(best_type);
+
+    return best_type;
+}
+
+void App::update_mem_budget() {
+    if (mem_budget_supported) {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_props{};
+        budget_props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+        VkPhysicalDeviceMemoryProperties2 mem_props{};
+        mem_props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        mem_props.pNext = &budget_props;
+
+        vkGetPhysicalDeviceMemoryProperties2(phy_dev, &mem_props);
+
+        for (uint32_t i = 0; i < phy_dev_mem_props.memoryHeapCount; i++) {
+            heap_budgets[i] = budget_props.heapBudget[i];
+            heap_usages[i] = budget_props.heapUsage[i];
+        }
+    } else {
+        for (uint32_t i = 0; i < phy_dev_mem_props.memoryHeapCount; i++) {
+            heap_budgets[i] = phy_dev_mem_props.memoryHeaps[i].size * MEM_FALLBACK_BUDGET_PERCENT / 100;
+            heap_usages[i] = heap_alloc_bytes[i];
+        }
+    }
+
+    heap_alloc_bytes_at_query = heap_alloc_bytes;
+}
+
+// the driver reported usage lags behind, so add what was allocated since the last query
+VkDeviceSize App::get_heap_usage(uint32_t heap) {
+    VkDeviceSize usage = heap_usages[heap] + heap_alloc_bytes[heap];
+    VkDeviceSize at_query = heap_alloc_bytes_at_query[heap];
+
+    return usage > at_query ? usage - at_query : 0;
+}
+
+bool App::heap_within_budget(uint32_t mem_type, VkDeviceSize size) {
+    uint32_t heap = phy_dev_mem_props.memoryTypes[mem_type].heapIndex;
+    return get_heap_usage(heap) + size <= heap_budgets[heap];
+}
+
+VkDeviceSize App::get_mem_block_size(uint32_t mem_type) {
+    // small heaps (e.g. the 256 MiB BAR heap) should not be eaten by a handful of blocks
+    VkDeviceSize heap_size = phy_dev_mem_props.memoryHeaps[phy_dev_mem_props.memoryTypes[mem_type].heapIndex].size;
+    return std::min<VkDeviceSize>(MEM_BLOCK_SIZE, heap_size / 8);
+}
+
+uint32_t App::create_mem_block(uint32_t mem_type, VkDeviceSize size, bool linear, bool dedicated) {
+    uint32_t live_blocks = 0;
+    for (const auto &block: mem_blocks)
+        if (block.mem != VK_NULL_HANDLE)
+            live_blocks++;
+
+    if (live_blocks >= phy_dev_props.limits.maxMemoryAllocationCount)
+        throw std::runtime_error("exceeded max memory allocation count.");
+
+    VCW_MemoryBlock block{};
+    block.size = size;
+    block.mem_type = mem_type;
+    block.linear = linear;
+    block.dedicated = dedicated;
+    block.used = 0;
+    block.alloc_count = 0;
+    block.free_ranges.push_back({0, size});
+
+    VkMemoryAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = size;
+    alloc_info.memoryTypeIndex = mem_type;
+
+    if (vkAllocateMemory(dev, &alloc_info, nullptr, &block.mem) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate device memory block.");
+
+    heap_alloc_bytes[phy_dev_mem_props.memoryTypes[mem_type].heapIndex] += size;
+
+    // reuse slots of released blocks, so allocation handles stay valid
+    for (uint32_t i = 0; i < mem_blocks.size(); i++) {
+        if (mem_blocks[i].mem == VK_NULL_HANDLE) {
+            mem_blocks[i] = block;
+            return i;
+        }
+    }
+
+    mem_blocks.push_back(block);
+    return static_cast<uint32_t>(mem_blocks.size() - 1);
+}
+
+// first fit over the free list of a block
+bool App::suballoc_mem_block(VCW_MemoryBlock *p_block, VkDeviceSize size, VkDeviceSize alignment,
+                             VkDeviceSize *p_offset) {
+    for (size_t i = 0; i < p_block->free_ranges.size(); i++) {
+        VCW_MemoryRange range = p_block->free_ranges[i];
+        VkDeviceSize offset = align_up(range.offset, alignment);
+
+        if (offset + size > range.offset + range.size)
+            continue;
+
+        VCW_MemoryRange head = {range.offset, offset - range.offset};
+        VCW_MemoryRange tail = {offset + size, range.offset + range.size - (offset + size)};
+
+        p_block->free_ranges.erase(p_block->free_ranges.begin() + static_cast<std::ptrdiff_t>(i));
+        if (tail.size > 0)
+            p_block->free_ranges.insert(p_block->free_ranges.begin() + static_cast<std::ptrdiff_t>(i), tail);
+        if (head.size > 0)
+            p_block->free_ranges.insert(p_block->free_ranges.begin() + static_cast<std::ptrdiff_t>(i), head);
+
+        p_block->used += size;
+        p_block->alloc_count++;
+        *p_offset = offset;
+        return true;
+    }
+
+    return false;
+}
+
+VCW_Allocation App::alloc_mem(VkMemoryRequirements mem_reqs, VkMemoryPropertyFlags mem_props,
+                              VkMemoryPropertyFlags pref_mem_props, bool linear) {
+    uint32_t type_filter = mem_reqs.memoryTypeBits;
+    uint32_t mem_type = find_mem_type(type_filter, mem_props, pref_mem_props);
+
+    VCW_Allocation alloc{};
+    alloc.size = mem_reqs.size;
+
+    while (true) {
+        VkDeviceSize block_size = get_mem_block_size(mem_type);
+        bool dedicated = mem_reqs.size > block_size / 2;
+        alloc.mem_flags = phy_dev_mem_props.memoryTypes[mem_type].propertyFlags;
+
+        if (!dedicated) {
+            for (uint32_t i = 0; i < mem_blocks.size(); i++) {
+                VCW_MemoryBlock &block = mem_blocks[i];
+                if (block.mem == VK_NULL_HANDLE || block.dedicated || block.mem_type != mem_type ||
+                    block.linear != linear)
+                    continue;
+
+                if (suballoc_mem_block(&block, mem_reqs.size, mem_reqs.alignment, &alloc.offset)) {
+                    alloc.block = i;
+                    alloc.mem = block.mem;
+                    return alloc;
+                }
+            }
+        }
+
+        // growing this heap would exceed its budget, try the next best type before giving up on it
+        VkDeviceSize new_size = dedicated ? mem_reqs.size : block_size;
+        uint32_t remaining_types = type_filter & ~(1u << mem_type);
+        int fallback_type = resolve_mem_type(remaining_types, mem_props, pref_mem_props);
+
+        if (!heap_within_budget(mem_type, new_size) && fallback_type >= 0) {
+            type_filter = remaining_types;
+            mem_type = static_cast<uint32_t>(fallback_type);
+            continue;
+        }
+
+        alloc.block = create_mem_block(mem_type, new_size, linear, dedicated);
+        VCW_MemoryBlock &block = mem_blocks[alloc.block];
+        alloc.mem = block.mem;
+
+        if (dedicated) {
+            alloc.offset = 0;
+            block.free_ranges.clear();
+            block.used = mem_reqs.size;
+            block.alloc_count = 1;
+        } else if (!suballoc_mem_block(&block, mem_reqs.size, mem_reqs.alignment, &alloc.offset)) {
+            throw std::runtime_error("failed to sub-allocate device memory.");
+        }
+
+        return alloc;
+    }
+}
+
+// the whole block is mapped once and stays mapped, vkMapMemory cannot map the same memory twice
+void *App::map_mem(VCW_Allocation alloc) {
+    VCW_MemoryBlock &block = mem_blocks[alloc.block];
+
+    if (block.p_mapped_mem == nullptr)
+        if (vkMapMemory(dev, block.mem, 0, VK_WHOLE_SIZE, 0, &block.p_mapped_mem) != VK_SUCCESS)
+            throw std::runtime_error("failed to map device memory block.");
+
+    return static_cast<char *>(block.p_mapped_mem) + alloc.offset;
+}
+
+void App::free_mem(VCW_Allocation alloc) {
+    VCW_MemoryBlock &block = mem_blocks[alloc.block];
+
+    block.used -= alloc.size;
+    block.alloc_count--;
+
+    if (!block.dedicated) {
+        auto it = std::lower_bound(block.free_ranges.begin(), block.free_ranges.end(), alloc.offset,
+                                   [](const VCW_MemoryRange &range, VkDeviceSize offset) {
+                                       return range.offset < offset;
+                                   });
+        it = block.free_ranges.insert(it, {alloc.offset, alloc.size});
+
+        auto next = it + 1;
+        if (next != block.free_ranges.end() && it->offset + it->size == next->offset) {
+            it->size += next->size;
+            block.free_ranges.erase(next);
+        }
+
+        if (it != block.free_ranges.begin()) {
+            auto prev = it - 1;
+            if (prev->offset + prev->size == it->offset) {
+                prev->size += it->size;
+                block.free_ranges.erase(it);
+            }
+        }
+    }
+
+    if (block.alloc_count > 0)
+        return;
+
+    // keep one empty block per memory type around, so recreating the swapchain does not hit the driver
+    bool keep = !block.dedicated;
+    if (keep) {
+        for (uint32_t i = 0; i < mem_blocks.size(); i++) {
+            const VCW_MemoryBlock &other = mem_blocks[i];
+            if (i != alloc.block && other.mem != VK_NULL_HANDLE && !other.dedicated && other.alloc_count == 0 &&
+                other.mem_type == block.mem_type && other.linear == block.linear) {
+                keep = false;
+                break;
+            }
+        }
+    }
+
+    if (keep)
+        return;
+
+    if (block.p_mapped_mem != nullptr)
+        vkUnmapMemory(dev, block.mem);
+    vkFreeMemory(dev, block.mem, nullptr);
+    heap_alloc_bytes[phy_dev_mem_props.memoryTypes[block.mem_type].heapIndex] -= block.size;
+
+    block = VCW_MemoryBlock{};
+}
+
+VCW_MemoryStats App::get_mem_stats() {
+    VCW_MemoryStats mem_stats{};
+
+    VkDeviceSize total_free = 0;
+    VkDeviceSize largest_free = 0;
+
+    for (const auto &block: mem_blocks) {
+        if (block.mem == VK_NULL_HANDLE)
+            continue;
+
+        mem_stats.block_count++;
+        mem_stats.alloc_count += block.alloc_count;
+        mem_stats.bytes_reserved += block.size;
+        mem_stats.bytes_used += block.used;
+
+        for (const auto &range: block.free_ranges) {
+            total_free += range.size;
+            largest_free = std::max(largest_free, range.size);
+        }
+    }
+
+    mem_stats.fragmentation = total_free > 0 ? 1.0f - (float) largest_free / (float) total_free : 0.0f;
+
+    return mem_stats;
+}
+
+void App::clean_up_mem() {
+    for (auto &block: mem_blocks) {
+        if (block.mem == VK_NULL_HANDLE)
+            continue;
+
+        if (block.p_mapped_mem != nullptr)
+            vkUnmapMemory(dev, block.mem);
+        vkFreeMemory(dev, block.mem, nullptr);
+    }
+
+    mem_blocks.clear();
+    heap_alloc_bytes.fill(0);
+}
@@ -18,7 +18,7 @@ void App::create_rendp() {
 #ifdef INTERMEDIATE_RENDER_TARGET
     color_attach.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 #else
-    color_attach.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    color_attach.finalLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 #endif
     attachments.push_back(color_attach);
 
@@ -97,7 +97,8 @@ VkShaderModule App::create_shader_mod(const std::vector<char> &code) {
 }
 
 void App::create_render_targets() {
-    render_targets.resize(swap_imgs.size());
+    // headless renders into one target per frame in flight, there are no swapchain images
+    render_targets.resize(headless ? frames_in_flight : swap_imgs.size());
 
     for (auto &render_target: render_targets) {
         render_target = create_img(swap_extent, swap_img_format, VK_IMAGE_TILING_OPTIMAL,
@@ -110,9 +111,9 @@ void App::create_render_targets() {
 }
 
 void App::create_frame_bufs(std::vector<VCW_Image> img_targets) {
-    frame_bufs.resize(swap_imgs.size());
+    frame_bufs.resize(img_targets.size());
 
-    for (size_t i = 0; i < swap_imgs.size(); i++) {
+    for (size_t i = 0; i < img_targets.size(); i++) {
         std::vector<VkImageView> attachments = {img_targets[i].view};
 #ifdef ENABLE_DEPTH_TESTING
         attachments.push_back(depth_img.view);
@@ -136,4 +137,69 @@ void App::clean_up_pipe() {
     vkDestroyPipeline(dev, pipe, nullptr);
     vkDestroyPipelineLayout(dev, pipe_layout, nullptr);
     vkDestroyRenderPass(dev, rendp, nullptr);
-}
\ No newline at end of file
+}
+
+// a cache written by another driver or device is ignored, the driver would reject or misuse it
+void App::create_pipe_cache() {
+    std::vector<char> cache_data;
+
+    std::ifstream file(PIPELINE_CACHE_FILE, std::ios::ate | std::ios::binary);
+    if (file.is_open()) {
+        cache_data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(cache_data.data(), static_cast<std::streamsize>(cache_data.size()));
+        file.close();
+    }
+
+    VkPipelineCacheHeaderVersionOne header{};
+    if (cache_data.size() >= sizeof(header)) {
+        memcpy(&header, cache_data.data(), sizeof(header));
+
+        pipe_cache_warm = header.headerSize >= sizeof(header) &&
+                          header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                          header.vendorID == phy_dev_props.vendorID &&
+                          header.deviceID == phy_dev_props.deviceID &&
+                          memcmp(header.pipelineCacheUUID, phy_dev_props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    VkPipelineCacheCreateInfo cache_info{};
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    if (pipe_cache_warm) {
+        cache_info.initialDataSize = cache_data.size();
+        cache_info.pInitialData = cache_data.data();
+    }
+
+    if (vkCreatePipelineCache(dev, &cache_info, nullptr, &pipe_cache) != VK_SUCCESS)
+        throw std::runtime_error("failed to create pipeline cache.");
+}
+
+// written to a temporary file first, a crash while writing never leaves a truncated cache behind
+void App::save_pipe_cache() {
+    size_t data_size = 0;
+    if (vkGetPipelineCacheData(dev, pipe_cache, &data_size, nullptr) != VK_SUCCESS || data_size == 0)
+        return;
+
+    std::vector<char> cache_data(data_size);
+    if (vkGetPipelineCacheData(dev, pipe_cache, &data_size, cache_data.data()) != VK_SUCCESS)
+        return;
+
+    std::string tmp_path = std::string(PIPELINE_CACHE_FILE) + ".tmp";
+
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return;
+
+    file.write(cache_data.data(), static_cast<std::streamsize>(data_size));
+    file.close();
+    if (file.fail())
+        return;
+
+    std::error_code err;
+    std::filesystem::rename(tmp_path, PIPELINE_CACHE_FILE, err);
+    if (err)
+        std::filesystem::remove(tmp_path, err);
+}
+
+void App::clean_up_pipe_cache() {
+    vkDestroyPipelineCache(dev, pipe_cache, nullptr);
+}
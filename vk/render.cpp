@@ -12,6 +12,11 @@ void App::create_cmd_pool() {
 
     if (vkCreateCommandPool(dev, &cmd_pool_info, nullptr, &cmd_pool) != VK_SUCCESS)
         throw std::runtime_error("failed to create graphics command pool.");
+
+    cmd_pool_info.queueFamilyIndex = qf_upload;
+
+    if (vkCreateCommandPool(dev, &cmd_pool_info, nullptr, &upload_cmd_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create upload command pool.");
 }
 
 VkCommandBuffer App::begin_single_time_cmd() {
@@ -47,46 +52,104 @@ void App::end_single_time_cmd(VkCommandBuffer cmd_buf) {
     vkFreeCommandBuffers(dev, cmd_pool, 1, &cmd_buf);
 }
 
+// every frame in flight gets its own pools, they are reset as a whole instead of per command buffer
 void App::create_cmd_bufs() {
-    cmd_bufs.resize(MAX_FRAMES_IN_FLIGHT);
+    cmd_bufs.resize(frames_in_flight);
+    frame_cmd_pools.resize(frames_in_flight);
+
+    uint32_t part_count = thread_pool.size() + 1;
+
+    VkCommandPoolCreateInfo cmd_pool_info{};
+    cmd_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    cmd_pool_info.queueFamilyIndex = qf_indices.qf_graph.value();
 
     VkCommandBufferAllocateInfo alloc_info{};
     alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    alloc_info.commandPool = cmd_pool;
-    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    alloc_info.commandBufferCount = (uint32_t) cmd_bufs.size();
+    alloc_info.commandBufferCount = 1;
+
+    for (size_t i = 0; i < frames_in_flight; i++) {
+        VCW_FrameCmdPools &frame_pools = frame_cmd_pools[i];
+
+        if (vkCreateCommandPool(dev, &cmd_pool_info, nullptr, &frame_pools.pool) != VK_SUCCESS)
+            throw std::runtime_error("failed to create frame command pool.");
+
+        alloc_info.commandPool = frame_pools.pool;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        if (vkAllocateCommandBuffers(dev, &alloc_info, &cmd_bufs[i]) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate command buffers.");
+
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        if (vkAllocateCommandBuffers(dev, &alloc_info, &frame_pools.ui_cmd_buf) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate command buffers.");
 
-    if (vkAllocateCommandBuffers(dev, &alloc_info, cmd_bufs.data()) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate command buffers.");
+        frame_pools.part_pools.resize(part_count);
+        frame_pools.part_cmd_bufs.resize(part_count);
+
+        for (uint32_t part = 0; part < part_count; part++) {
+            if (vkCreateCommandPool(dev, &cmd_pool_info, nullptr, &frame_pools.part_pools[part]) != VK_SUCCESS)
+                throw std::runtime_error("failed to create frame command pool.");
+
+            alloc_info.commandPool = frame_pools.part_pools[part];
+            if (vkAllocateCommandBuffers(dev, &alloc_info, &frame_pools.part_cmd_bufs[part]) != VK_SUCCESS)
+                throw std::runtime_error("failed to allocate command buffers.");
+        }
     }
 }
 
+void App::reset_frame_cmd_pools(uint32_t frame) {
+    VCW_FrameCmdPools &frame_pools = frame_cmd_pools[frame];
+
+    vkResetCommandPool(dev, frame_pools.pool, 0);
+    for (auto &part_pool: frame_pools.part_pools)
+        vkResetCommandPool(dev, part_pool, 0);
+}
+
+void App::clean_up_cmd_bufs() {
+    for (auto &frame_pools: frame_cmd_pools) {
+        for (auto &part_pool: frame_pools.part_pools)
+            vkDestroyCommandPool(dev, part_pool, nullptr);
+        vkDestroyCommandPool(dev, frame_pools.pool, nullptr);
+    }
+    frame_cmd_pools.clear();
+}
+
 void App::create_sync() {
-    img_avl_semps.resize(MAX_FRAMES_IN_FLIGHT);
-    rend_fin_semps.resize(MAX_FRAMES_IN_FLIGHT);
-    fens.resize(MAX_FRAMES_IN_FLIGHT);
+    // binary semaphores remain for the swapchain, which can not use timelines
+    img_avl_semps.resize(frames_in_flight);
+    rend_fin_semps.resize(frames_in_flight);
+    frame_timeline_values.assign(frames_in_flight, 0);
 
     VkSemaphoreCreateInfo semp_info{};
     semp_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VkFenceCreateInfo fen_info{};
-    fen_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fen_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < frames_in_flight; i++) {
         if (vkCreateSemaphore(dev, &semp_info, nullptr, &img_avl_semps[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(dev, &semp_info, nullptr, &rend_fin_semps[i]) != VK_SUCCESS ||
-            vkCreateFence(dev, &fen_info, nullptr, &fens[i]) != VK_SUCCESS) {
+            vkCreateSemaphore(dev, &semp_info, nullptr, &rend_fin_semps[i]) != VK_SUCCESS) {
             throw std::runtime_error("failed to create synchronization objects.");
         }
     }
+
+    VkSemaphoreTypeCreateInfo timeline_info{};
+    timeline_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    timeline_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    timeline_info.initialValue = 0;
+    semp_info.pNext = &timeline_info;
+
+    if (vkCreateSemaphore(dev, &semp_info, nullptr, &gfx_timeline) != VK_SUCCESS ||
+        vkCreateSemaphore(dev, &semp_info, nullptr, &upload_timeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timeline semaphores.");
+    }
+
+    gfx_timeline_value = 0;
+    upload_timeline_value = 0;
 }
 
 void App::create_query_pool(uint32_t loc_frame_query_count) {
     VkQueryPoolCreateInfo query_pool_info{};
     query_pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
     query_pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
-    query_pool_info.queryCount = loc_frame_query_count * static_cast<uint32_t>(swap_imgs.size());
+    query_pool_info.queryCount = loc_frame_query_count * frames_in_flight;
 
     if (vkCreateQueryPool(dev, &query_pool_info, nullptr, &query_pool) != VK_SUCCESS)
         throw std::runtime_error("failed to create query pool.");
@@ -95,8 +158,72 @@ void App::create_query_pool(uint32_t loc_frame_query_count) {
 }
 
 
+uint64_t App::get_gfx_timeline_completed() {
+    uint64_t value;
+    if (vkGetSemaphoreCounterValue(dev, gfx_timeline, &value) != VK_SUCCESS)
+        throw std::runtime_error("failed to read graphics timeline.");
+
+    return value;
+}
+
+void App::wait_gfx_timeline(uint64_t value) {
+    VkSemaphoreWaitInfo wait_info{};
+    wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &gfx_timeline;
+    wait_info.pValues = &value;
+
+    if (vkWaitSemaphores(dev, &wait_info, UINT64_MAX) != VK_SUCCESS)
+        throw std::runtime_error("failed to wait for graphics timeline.");
+}
+
+// resources still referenced by submitted work are destroyed once the graphics timeline passes all of it,
+// delay holds them back for that many further graphics submissions
+void App::defer_deletion(std::function<void()> destroy, uint64_t delay) {
+    uint64_t timeline_value = gfx_timeline_value + delay;
+    // kept sorted, a delayed entry does not hold back the ones queued after it
+    auto pos = std::upper_bound(deletion_queue.begin(), deletion_queue.end(), timeline_value,
+                                [](uint64_t value, const VCW_DeferredDeletion &deletion) {
+                                    return value < deletion.timeline_value;
+                                });
+    deletion_queue.insert(pos, {timeline_value, std::move(destroy)});
+}
+
+// non-blocking
+void App::flush_deletions() {
+    if (deletion_queue.empty())
+        return;
+
+    uint64_t completed = get_gfx_timeline_completed();
+
+    while (!deletion_queue.empty() && deletion_queue.front().timeline_value <= completed) {
+        deletion_queue.front().destroy();
+        deletion_queue.pop_front();
+    }
+}
+
+void App::clean_up_deletions() {
+    // delayed entries may be ahead of the last submission
+    if (!deletion_queue.empty())
+        wait_gfx_timeline(std::min(deletion_queue.back().timeline_value, gfx_timeline_value));
+
+    while (!deletion_queue.empty()) {
+        deletion_queue.front().destroy();
+        deletion_queue.pop_front();
+    }
+}
+
 void App::render() {
-    vkWaitForFences(dev, 1, &fens[cur_frame], VK_TRUE, UINT64_MAX);
+    // the last submission of this slot is done, its command buffers, uniforms and timestamps are free
+    wait_gfx_timeline(frame_timeline_values[cur_frame]);
+    if (frame_timeline_values[cur_frame] > 0)
+        fetch_queries(cur_frame);
+
+    flush_deletions();
+    reset_frame_desc_pools(cur_frame);
+#ifdef ENABLE_DYNAMIC_UNIFORM
+    reset_dyn_unif_ring(cur_frame);
+#endif
 
     uint32_t img_index;
     VkResult result = vkAcquireNextImageKHR(dev, swap, UINT64_MAX, img_avl_semps[cur_frame],
@@ -111,10 +238,17 @@ void App::render() {
 
     update_bufs(cur_frame);
 
-    vkResetFences(dev, 1, &fens[cur_frame]);
+    retire_uploads();
+    update_tex_streaming();
+    flush_uploads();
+    write_frame_desc_set(cur_frame);
 
-    vkResetCommandBuffer(cmd_bufs[cur_frame], /*VkCommandBufferResetFlagBits*/ 0);
+    reset_frame_cmd_pools(cur_frame);
+
+    auto record_start_time = std::chrono::high_resolution_clock::now();
     record_cmd_buf(cmd_bufs[cur_frame], img_index);
+    auto record_end_time = std::chrono::high_resolution_clock::now();
+    stats.record_time = std::chrono::duration<double, std::milli>(record_end_time - record_start_time).count();
 
     VkSubmitInfo submit{};
     submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -128,18 +262,32 @@ void App::render() {
     submit.commandBufferCount = 1;
     submit.pCommandBuffers = &cmd_bufs[cur_frame];
 
-    VkSemaphore signal_semps[] = {rend_fin_semps[cur_frame]};
-    submit.signalSemaphoreCount = 1;
+    VkSemaphore signal_semps[] = {rend_fin_semps[cur_frame], gfx_timeline};
+    submit.signalSemaphoreCount = 2;
     submit.pSignalSemaphores = signal_semps;
 
-    if (vkQueueSubmit(q_graph, 1, &submit, fens[cur_frame]) != VK_SUCCESS)
+    // values of binary semaphores are ignored
+    uint64_t wait_values[] = {0};
+    uint64_t signal_values[] = {0, ++gfx_timeline_value};
+
+    VkTimelineSemaphoreSubmitInfo timeline_submit{};
+    timeline_submit.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_submit.waitSemaphoreValueCount = 1;
+    timeline_submit.pWaitSemaphoreValues = wait_values;
+    timeline_submit.signalSemaphoreValueCount = 2;
+    timeline_submit.pSignalSemaphoreValues = signal_values;
+    submit.pNext = &timeline_submit;
+
+    if (vkQueueSubmit(q_graph, 1, &submit, VK_NULL_HANDLE) != VK_SUCCESS)
         throw std::runtime_error("failed to submit render command buffer.");
 
+    frame_timeline_values[cur_frame] = gfx_timeline_value;
+
     VkPresentInfoKHR present{};
     present.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
     present.waitSemaphoreCount = 1;
-    present.pWaitSemaphores = signal_semps;
+    present.pWaitSemaphores = &rend_fin_semps[cur_frame];
 
     VkSwapchainKHR swaps[] = {swap};
     present.swapchainCount = 1;
@@ -156,15 +304,15 @@ void App::render() {
         throw std::runtime_error("failed to present swap chain image.");
     }
 
-    fetch_queries(img_index);
-
-    cur_frame = (cur_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+    cur_frame = (cur_frame + 1) % frames_in_flight;
 }
 
 void App::clean_up_sync() {
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < frames_in_flight; i++) {
         vkDestroySemaphore(dev, rend_fin_semps[i], nullptr);
         vkDestroySemaphore(dev, img_avl_semps[i], nullptr);
-        vkDestroyFence(dev, fens[i], nullptr);
     }
+
+    vkDestroySemaphore(dev, gfx_timeline, nullptr);
+    vkDestroySemaphore(dev, upload_timeline, nullptr);
 }
@@ -0,0 +1,257 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "../app.h"
+
+// decoding starts right away on the workers, the tail levels become resident once it is done
+uint32_t App::add_stream_tex(const std::string &path, glm::vec3 pos, float radius) {
+    VCW_StreamTexture tex{};
+    tex.path = path;
+    tex.pos = pos;
+    tex.radius = radius;
+    tex.pending = thread_pool.submit([this, path]() { return load_stream_data(path); });
+#ifdef STREAM_DRAWS
+    // written once the texture is resident, until then its object samples the default texture
+    for (uint32_t i = 0; i < frames_in_flight; i++)
+        tex.bindless_slots.push_back(reserve_bindless_tex());
+    tex.slot_versions.assign(frames_in_flight, UINT32_MAX);
+#endif
+
+    stream_texs.push_back(std::move(tex));
+
+    return static_cast<uint32_t>(stream_texs.size() - 1);
+}
+
+void App::add_stream_dir(const std::string &dir) {
+    std::vector<std::string> paths;
+    for (const auto &entry: std::filesystem::directory_iterator(dir)) {
+        std::string ext = entry.path().extension().string();
+        if (entry.is_regular_file() &&
+            (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".tga" || ext == ".bmp" || ext == ".ktx2" ||
+             ext == ".dds"))
+            paths.push_back(entry.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    for (size_t i = 0; i < paths.size(); i++)
+        add_stream_tex(paths[i], {0.0f, 0.0f, -static_cast<float>(i + 1) * STREAM_SPACING}, STREAM_RADIUS);
+}
+
+// runs on a worker, vkGetPhysicalDeviceFormatProperties needs no external synchronization
+VCW_ImageData App::load_stream_data(const std::string &path) {
+    VCW_ImageData img_data = load_img_data(path);
+
+    VkFormat format = find_supported_format({img_data.format, get_decoded_format(img_data.format)},
+                                            VK_IMAGE_TILING_OPTIMAL,
+                                            VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+                                            VK_FORMAT_FEATURE_TRANSFER_DST_BIT);
+    if (format != img_data.format)
+        decode_bc(img_data);
+
+    // finer levels are streamed from the cpu copy, so the chain cannot be generated on the gpu
+    build_mip_chain(img_data);
+
+    return img_data;
+}
+
+// finest level whose texels are not smaller than the pixels the object covers on screen
+uint32_t App::get_desired_base(const VCW_StreamTexture &tex) {
+#ifdef USE_CAMERA
+    float distance = std::max(tex.distance - tex.radius, cam.near);
+    float screen_size = tex.radius / (distance * std::tan(glm::radians(cam.fov) / 2.0f)) *
+                        static_cast<float>(render_extent.height);
+    float texel_size = static_cast<float>(std::max(tex.data.width, tex.data.height));
+
+    float base = std::floor(std::log2(texel_size / std::max(screen_size, 1.0f)));
+    return std::min(static_cast<uint32_t>(std::max(base, 0.0f)), tex.tail_base);
+#else
+    return 0;
+#endif
+}
+
+// the image is rebuilt with the new chain, the old one is destroyed once in-flight frames are done with it,
+// the texture's bindless slots are pointed at the new image as their frames come around
+void App::set_resident_base(VCW_StreamTexture *p_tex, uint32_t base) {
+    const VCW_ImageData &data = p_tex->data;
+
+    VkDeviceSize offset = 0;
+    for (uint32_t level = 0; level < base; level++)
+        offset += get_level_size(data.format, data.width, data.height, level, data.array_layers);
+
+    VkDeviceSize size = 0;
+    for (uint32_t level = base; level < data.mip_levels; level++)
+        size += get_level_size(data.format, data.width, data.height, level, data.array_layers);
+
+    VkExtent2D extent = {std::max(data.width >> base, 1u), std::max(data.height >> base, 1u)};
+    uint32_t levels = data.mip_levels - base;
+
+    if (p_tex->state == STREAM_RESIDENT) {
+        VCW_Image old_img = p_tex->img;
+        defer_deletion([this, old_img]() { clean_up_img(old_img); });
+    }
+
+    p_tex->img = create_img(extent, data.format, VK_IMAGE_TILING_OPTIMAL,
+                            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, levels, data.array_layers);
+    upload_to_img(&p_tex->img, data.pixels.data() + offset, size, levels);
+
+    create_img_view(&p_tex->img, VK_IMAGE_ASPECT_COLOR_BIT);
+    create_sampler(&p_tex->img, VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT);
+    p_tex->img_version++;
+
+    stream_stats.resident_bytes = stream_stats.resident_bytes - p_tex->resident_bytes + size;
+    p_tex->resident_bytes = size;
+    p_tex->resident_base = base;
+    p_tex->state = STREAM_RESIDENT;
+}
+
+// drops the finest level of the least recently used texture, a texture drawn this frame keeps the levels it wants
+bool App::evict_stream_level() {
+    VCW_StreamTexture *p_victim = nullptr;
+
+    for (auto &tex: stream_texs) {
+        if (tex.state != STREAM_RESIDENT || tex.resident_base >= tex.tail_base ||
+            (tex.last_use == stats.frame_count && tex.desired_base <= tex.resident_base))
+            continue;
+
+        if (!p_victim || tex.last_use < p_victim->last_use ||
+            (tex.last_use == p_victim->last_use && tex.distance > p_victim->distance))
+            p_victim = &tex;
+    }
+
+    if (!p_victim)
+        return false;
+
+    set_resident_base(p_victim, p_victim->resident_base + 1);
+    stream_stats.evictions++;
+
+    return true;
+}
+
+// after culling, the objects of resident textures sample the frame's slot, which update_tex_streaming points at
+// the current image before the frame is recorded
+void App::bind_stream_texs(uint32_t frame) {
+    for (auto &tex: stream_texs) {
+        if (tex.object == UINT32_MAX)
+            continue;
+
+        uint32_t tex_index = tex_bindless_index;
+        if (tex.state == STREAM_RESIDENT) {
+            tex_index = tex.bindless_slots[frame];
+            if (scene.visible[tex.object])
+                tex.last_use = stats.frame_count;
+        }
+#ifdef INSTANCING
+        instances[tex.object].material = tex_index;
+#else
+        draws[tex.object].tex_index = tex_index;
+#endif
+    }
+}
+
+// called once per frame before the uploads are flushed
+void App::update_tex_streaming() {
+    if (stream_texs.empty())
+        return;
+
+    stream_stats.pending_count = 0;
+    for (auto &tex: stream_texs) {
+        if (tex.state != STREAM_LOADING)
+            continue;
+
+        if (tex.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            stream_stats.pending_count++;
+            continue;
+        }
+
+        // one broken file should not take the scene down
+        try {
+            tex.data = tex.pending.get();
+        } catch (const std::exception &e) {
+            std::cerr << "failed to stream " << tex.path << ": " << e.what() << std::endl;
+            tex.state = STREAM_FAILED;
+            continue;
+        }
+
+        tex.tail_base = 0;
+        while (tex.tail_base + 1 < tex.data.mip_levels &&
+               std::max(tex.data.width >> tex.tail_base, tex.data.height >> tex.tail_base) > STREAM_TAIL_SIZE)
+            tex.tail_base++;
+
+        tex.last_use = stats.frame_count;
+        set_resident_base(&tex, tex.tail_base);
+    }
+
+    stream_stats.resident_count = 0;
+    stream_stats.wanted_bytes = 0;
+    std::vector<VCW_StreamTexture *> promotable;
+
+    for (auto &tex: stream_texs) {
+        if (tex.state != STREAM_RESIDENT)
+            continue;
+
+#ifdef USE_CAMERA
+        tex.distance = glm::length(tex.pos - cam.pos);
+#endif
+        tex.desired_base = get_desired_base(tex);
+#ifndef STREAM_DRAWS
+        // nothing draws the texture, wanting all its resident levels counts as a use
+        if (tex.desired_base <= tex.resident_base)
+            tex.last_use = stats.frame_count;
+#endif
+        if (tex.desired_base < tex.resident_base)
+            promotable.push_back(&tex);
+
+        stream_stats.resident_count++;
+        for (uint32_t level = tex.desired_base; level < tex.data.mip_levels; level++)
+            stream_stats.wanted_bytes += get_level_size(tex.data.format, tex.data.width, tex.data.height, level,
+                                                        tex.data.array_layers);
+    }
+
+    // a lowered budget is honoured even if nothing is promoted
+    while (stream_stats.resident_bytes > tex_budget && evict_stream_level()) {}
+
+    // nearest first, one level per texture and frame
+    std::sort(promotable.begin(), promotable.end(), [](const VCW_StreamTexture *a, const VCW_StreamTexture *b) {
+        return a->distance < b->distance;
+    });
+    if (promotable.size() > STREAM_PROMOTIONS_PER_FRAME)
+        promotable.resize(STREAM_PROMOTIONS_PER_FRAME);
+
+    for (VCW_StreamTexture *p_tex: promotable) {
+        const VCW_ImageData &data = p_tex->data;
+        VkDeviceSize level_size = get_level_size(data.format, data.width, data.height, p_tex->resident_base - 1,
+                                                 data.array_layers);
+
+        while (stream_stats.resident_bytes + level_size > tex_budget && evict_stream_level()) {}
+        if (stream_stats.resident_bytes + level_size > tex_budget)
+            break;
+
+        set_resident_base(p_tex, p_tex->resident_base - 1);
+        stream_stats.promotions++;
+    }
+
+#ifdef STREAM_DRAWS
+    // the frame's previous submission is done, so its slot is not pending and can follow the rebuilt image
+    for (auto &tex: stream_texs) {
+        if (tex.state == STREAM_RESIDENT && tex.slot_versions[cur_frame] != tex.img_version) {
+            write_bindless_tex(tex.bindless_slots[cur_frame], tex.img);
+            tex.slot_versions[cur_frame] = tex.img_version;
+        }
+    }
+#endif
+}
+
+// the device is idle
+void App::clean_up_tex_streaming() {
+    for (auto &tex: stream_texs) {
+        // the decode jobs query the physical device
+        if (tex.pending.valid())
+            tex.pending.wait();
+
+        if (tex.state == STREAM_RESIDENT)
+            clean_up_img(tex.img);
+    }
+    stream_texs.clear();
+}
@@ -0,0 +1,87 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "../app.h"
+
+//
+// one buffer split into a region per frame in flight, a region is written again once its frame retired
+//
+void App::create_dyn_unif_ring() {
+    dyn_unif_align = std::max(phy_dev_props.limits.minUniformBufferOffsetAlignment,
+                              phy_dev_props.limits.minStorageBufferOffsetAlignment);
+
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    dyn_unif_set_layout = get_desc_set_layout({binding});
+
+    VkDescriptorPoolSize pool_size{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1};
+
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    pool_info.maxSets = 1;
+
+    if (vkCreateDescriptorPool(dev, &pool_info, nullptr, &dyn_unif_pool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create dynamic uniform descriptor pool.");
+
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = dyn_unif_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &dyn_unif_set_layout;
+
+    if (vkAllocateDescriptorSets(dev, &alloc_info, &dyn_unif_set) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate dynamic uniform descriptor set.");
+}
+
+// a region holds a slice for every object, the set is rewritten, so the device has to be idle when it grows
+void App::create_dyn_unif_buf(uint32_t count) {
+    VkDeviceSize slice_size = (sizeof(VCW_ObjectUniform) + dyn_unif_align - 1) / dyn_unif_align * dyn_unif_align;
+    VkDeviceSize frame_size = std::max<VkDeviceSize>(DYNAMIC_UNIFORM_FRAME_SIZE, count * slice_size);
+    frame_size = (frame_size + dyn_unif_align - 1) / dyn_unif_align * dyn_unif_align;
+    if (frame_size <= dyn_unif_frame_size)
+        return;
+
+    if (dyn_unif_frame_size > 0)
+        clean_up_buf(dyn_unif_buf);
+    dyn_unif_frame_size = frame_size;
+
+    // device local where the host can write it directly (resizable bar, uma), system memory otherwise
+    dyn_unif_buf = create_buf(dyn_unif_frame_size * frames_in_flight,
+                              VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    map_buf(&dyn_unif_buf);
+
+    // slices are addressed by their absolute offset, so one descriptor covers the regions of all frames
+    write_buf_desc_binding({dyn_unif_buf.buf, 0, sizeof(VCW_ObjectUniform)}, dyn_unif_set, 0,
+                           VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+}
+
+// the frame's last submission has completed
+void App::reset_dyn_unif_ring(uint32_t frame) {
+    dyn_unif_frame = frame;
+    dyn_unif_head = 0;
+}
+
+// valid until the frame's region is reset, the offset is the dynamic offset of dyn_unif_set
+VCW_UniformSlice App::alloc_dyn_unif(VkDeviceSize size) {
+    VkDeviceSize offset = (dyn_unif_head + dyn_unif_align - 1) / dyn_unif_align * dyn_unif_align;
+    if (offset + size > dyn_unif_frame_size)
+        throw std::runtime_error("dynamic uniform ring is full.");
+
+    dyn_unif_head = offset + size;
+
+    VkDeviceSize buf_offset = dyn_unif_frame * dyn_unif_frame_size + offset;
+    return {static_cast<char *>(dyn_unif_buf.p_mapped_mem) + buf_offset, static_cast<uint32_t>(buf_offset)};
+}
+
+void App::clean_up_dyn_unif_ring() {
+    vkDestroyDescriptorPool(dev, dyn_unif_pool, nullptr);
+    clean_up_buf(dyn_unif_buf);
+}
@@ -0,0 +1,348 @@
+//
+// Created by Ludw on 10/17/2026.
+//
+
+#include "../app.h"
+
+void App::create_staging_ring() {
+    staging_ring = create_buf(STAGING_RING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    map_buf(&staging_ring);
+
+    staging_head = 0;
+    staging_tail = 0;
+}
+
+void App::begin_upload_batch() {
+    if (!free_upload_batches.empty()) {
+        upload_batch = free_upload_batches.back();
+        free_upload_batches.pop_back();
+    } else {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc_info.commandPool = upload_cmd_pool;
+        alloc_info.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(dev, &alloc_info, &upload_batch.cmd_buf) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate upload command buffer.");
+
+        upload_batch.gfx_cmd_buf = VK_NULL_HANDLE;
+
+        if (dedicated_upload_queue) {
+            alloc_info.commandPool = cmd_pool;
+
+            if (vkAllocateCommandBuffers(dev, &alloc_info, &upload_batch.gfx_cmd_buf) != VK_SUCCESS)
+                throw std::runtime_error("failed to allocate upload acquire command buffer.");
+        }
+    }
+
+    upload_batch.overflow_bufs.clear();
+    upload_batch.tmp_views.clear();
+    upload_batch.tmp_desc_pools.clear();
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(upload_batch.cmd_buf, &begin_info) != VK_SUCCESS)
+        throw std::runtime_error("failed to begin recording upload command buffer.");
+
+    if (dedicated_upload_queue)
+        if (vkBeginCommandBuffer(upload_batch.gfx_cmd_buf, &begin_info) != VK_SUCCESS)
+            throw std::runtime_error("failed to begin recording upload acquire command buffer.");
+
+    upload_recording = true;
+}
+
+VCW_StagingRegion App::reserve_staging(VkDeviceSize size, VkDeviceSize alignment) {
+    if (!upload_recording)
+        begin_upload_batch();
+
+    VCW_StagingRegion region{};
+
+    // does not fit at all, give it a temporary buffer that retires with the batch
+    if (size > staging_ring.size) {
+        region.buf = create_buf(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        map_buf(&region.buf);
+        region.offset = 0;
+        region.p_mapped_mem = region.buf.p_mapped_mem;
+
+        upload_batch.overflow_bufs.push_back(region.buf);
+        return region;
+    }
+
+    while (true) {
+        uint64_t pos = align_up(staging_head, alignment);
+        // regions never wrap around the end of the ring
+        if (pos % staging_ring.size + size > staging_ring.size)
+            pos = align_up(pos, staging_ring.size);
+
+        if (pos + size - staging_tail <= staging_ring.size) {
+            staging_head = pos + size;
+
+            region.buf = staging_ring;
+            region.offset = pos % staging_ring.size;
+            region.p_mapped_mem = static_cast<char *>(staging_ring.p_mapped_mem) + region.offset;
+            return region;
+        }
+
+        // ring is full, wait for the oldest batch or push out the one being recorded
+        if (!upload_batches.empty()) {
+            wait_gfx_timeline(upload_batches.front().timeline_value);
+            retire_upload_batch();
+        } else {
+            flush_uploads();
+            begin_upload_batch();
+        }
+    }
+}
+
+void App::upload_to_buf(VCW_Buffer dst_buf, const void *p_data, VkDeviceSize size, VkDeviceSize dst_offset) {
+    // host visible destination (uma or resizable bar) the gpu has not seen yet, no staging copy needed,
+    // once a submission may use the buffer the write is ordered behind it through the upload batch instead
+    VkMemoryPropertyFlags host_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    if ((dst_buf.alloc.mem_flags & host_flags) == host_flags && dst_buf.create_timeline_value == gfx_timeline_value) {
+        memcpy(static_cast<char *>(map_mem(dst_buf.alloc)) + dst_offset, p_data, size);
+        return;
+    }
+
+    VCW_StagingRegion region = reserve_staging(size, 16);
+    memcpy(region.p_mapped_mem, p_data, size);
+
+    VkBufferCopy cp_region{};
+    cp_region.srcOffset = region.offset;
+    cp_region.dstOffset = dst_offset;
+    cp_region.size = size;
+    vkCmdCopyBuffer(upload_batch.cmd_buf, region.buf.buf, dst_buf.buf, 1, &cp_region);
+
+    if (dedicated_upload_queue)
+        transfer_buf_ownership(dst_buf, dst_offset, size);
+}
+
+// data holds the first data_levels levels back to back, the rest of the chain is generated
+void App::upload_to_img(VCW_Image *p_img, const void *p_data, VkDeviceSize size, uint32_t data_levels) {
+    VCW_StagingRegion region = reserve_staging(size, 16);
+    memcpy(region.p_mapped_mem, p_data, size);
+
+    transition_img_layout(upload_batch.cmd_buf, p_img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                          VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    VkDeviceSize level_offset = region.offset;
+    for (uint32_t level = 0; level < data_levels; level++) {
+        VkExtent2D extent = {std::max(p_img->extent.width >> level, 1u), std::max(p_img->extent.height >> level, 1u)};
+        cp_buf_to_img(upload_batch.cmd_buf, region.buf, *p_img, extent, level_offset, level);
+
+        level_offset += get_level_size(p_img->format, p_img->extent.width, p_img->extent.height, level,
+                                       p_img->array_layers);
+    }
+
+    if (p_img->mip_levels > data_levels) {
+        // blits and dispatches need the graphics queue, the image moves there before the chain is built
+        if (dedicated_upload_queue)
+            transfer_img_ownership(p_img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                   VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+        generate_mips(dedicated_upload_queue ? upload_batch.gfx_cmd_buf : upload_batch.cmd_buf, p_img);
+    } else if (dedicated_upload_queue)
+        transfer_img_ownership(p_img, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    else
+        transition_img_layout(upload_batch.cmd_buf, p_img, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+//
+// resources are exclusive to one queue family, so the upload queue releases them
+// and the graphics queue acquires them with a matching barrier
+//
+void App::transfer_buf_ownership(VCW_Buffer buf, VkDeviceSize offset, VkDeviceSize size) {
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = qf_upload;
+    barrier.dstQueueFamilyIndex = qf_indices.qf_graph.value();
+    barrier.buffer = buf.buf;
+    barrier.offset = offset;
+    barrier.size = size;
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(upload_batch.cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                            VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(upload_batch.gfx_cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+// the layout transition is part of both barriers and happens once
+void App::transfer_img_ownership(VCW_Image *p_img, VkImageLayout layout, VkPipelineStageFlags dst_stage) {
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = p_img->cur_layout;
+    barrier.newLayout = layout;
+    barrier.srcQueueFamilyIndex = qf_upload;
+    barrier.dstQueueFamilyIndex = qf_indices.qf_graph.value();
+    barrier.image = p_img->img;
+    barrier.subresourceRange = get_subresource_range(*p_img);
+
+    barrier.srcAccessMask = get_access_mask(p_img->cur_layout);
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(upload_batch.cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = get_access_mask(layout);
+    vkCmdPipelineBarrier(upload_batch.gfx_cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dst_stage,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    p_img->cur_layout = layout;
+}
+
+// submits everything recorded since the last flush, returns the token of the batch
+uint64_t App::flush_uploads() {
+    if (!upload_recording)
+        return upload_token;
+
+    if (!dedicated_upload_queue) {
+        // make buffer copies visible to every later submission on the queue
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                                VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(upload_batch.cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    if (vkEndCommandBuffer(upload_batch.cmd_buf) != VK_SUCCESS)
+        throw std::runtime_error("failed to record upload command buffer.");
+
+    VkTimelineSemaphoreSubmitInfo timeline_submit{};
+    timeline_submit.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_submit.signalSemaphoreValueCount = 1;
+
+    VkSubmitInfo submit{};
+    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit.pNext = &timeline_submit;
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &upload_batch.cmd_buf;
+    submit.signalSemaphoreCount = 1;
+
+    if (dedicated_upload_queue) {
+        if (vkEndCommandBuffer(upload_batch.gfx_cmd_buf) != VK_SUCCESS)
+            throw std::runtime_error("failed to record upload acquire command buffer.");
+
+        uint64_t copy_value = ++upload_timeline_value;
+        timeline_submit.pSignalSemaphoreValues = &copy_value;
+        submit.pSignalSemaphores = &upload_timeline;
+
+        if (vkQueueSubmit(q_upload, 1, &submit, VK_NULL_HANDLE) != VK_SUCCESS)
+            throw std::runtime_error("failed to submit upload command buffer.");
+
+        // the acquire waits for the copies, so its graphics timeline value covers the whole batch
+        VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        uint64_t acquire_value = ++gfx_timeline_value;
+
+        VkTimelineSemaphoreSubmitInfo acquire_timeline_submit{};
+        acquire_timeline_submit.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        acquire_timeline_submit.waitSemaphoreValueCount = 1;
+        acquire_timeline_submit.pWaitSemaphoreValues = &copy_value;
+        acquire_timeline_submit.signalSemaphoreValueCount = 1;
+        acquire_timeline_submit.pSignalSemaphoreValues = &acquire_value;
+
+        VkSubmitInfo acquire_submit{};
+        acquire_submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        acquire_submit.pNext = &acquire_timeline_submit;
+        acquire_submit.waitSemaphoreCount = 1;
+        acquire_submit.pWaitSemaphores = &upload_timeline;
+        acquire_submit.pWaitDstStageMask = &wait_stage;
+        acquire_submit.commandBufferCount = 1;
+        acquire_submit.pCommandBuffers = &upload_batch.gfx_cmd_buf;
+        acquire_submit.signalSemaphoreCount = 1;
+        acquire_submit.pSignalSemaphores = &gfx_timeline;
+
+        if (vkQueueSubmit(q_graph, 1, &acquire_submit, VK_NULL_HANDLE) != VK_SUCCESS)
+            throw std::runtime_error("failed to submit upload acquire command buffer.");
+    } else {
+        // the upload queue is the graphics queue, the copies advance its timeline directly
+        uint64_t copy_value = ++gfx_timeline_value;
+        timeline_submit.pSignalSemaphoreValues = &copy_value;
+        submit.pSignalSemaphores = &gfx_timeline;
+
+        if (vkQueueSubmit(q_upload, 1, &submit, VK_NULL_HANDLE) != VK_SUCCESS)
+            throw std::runtime_error("failed to submit upload command buffer.");
+    }
+
+    upload_batch.timeline_value = gfx_timeline_value;
+    upload_batch.token = ++upload_token;
+    upload_batch.ring_end = staging_head;
+    upload_batches.push_back(upload_batch);
+
+    upload_recording = false;
+
+    return upload_token;
+}
+
+void App::retire_upload_batch() {
+    VCW_UploadBatch batch = upload_batches.front();
+    upload_batches.pop_front();
+
+    for (auto &buf: batch.overflow_bufs)
+        clean_up_buf(buf);
+    batch.overflow_bufs.clear();
+
+    for (auto &view: batch.tmp_views)
+        vkDestroyImageView(dev, view, nullptr);
+    batch.tmp_views.clear();
+
+    for (auto &desc_pool: batch.tmp_desc_pools)
+        vkDestroyDescriptorPool(dev, desc_pool, nullptr);
+    batch.tmp_desc_pools.clear();
+
+    staging_tail = batch.ring_end;
+    upload_completed = batch.token;
+
+    vkResetCommandBuffer(batch.cmd_buf, 0);
+    if (batch.gfx_cmd_buf != VK_NULL_HANDLE)
+        vkResetCommandBuffer(batch.gfx_cmd_buf, 0);
+    free_upload_batches.push_back(batch);
+}
+
+// non-blocking, releases staging memory of every batch the gpu is done with
+void App::retire_uploads() {
+    uint64_t completed = get_gfx_timeline_completed();
+
+    while (!upload_batches.empty() && upload_batches.front().timeline_value <= completed)
+        retire_upload_batch();
+}
+
+void App::wait_uploads(uint64_t token) {
+    if (upload_recording && token > upload_token)
+        flush_uploads();
+
+    while (!upload_batches.empty() && upload_completed < token) {
+        wait_gfx_timeline(upload_batches.front().timeline_value);
+        retire_upload_batch();
+    }
+}
+
+void App::clean_up_staging_ring() {
+    flush_uploads();
+    wait_uploads(upload_token);
+
+    for (auto &batch: free_upload_batches) {
+        vkFreeCommandBuffers(dev, upload_cmd_pool, 1, &batch.cmd_buf);
+
+        if (batch.gfx_cmd_buf != VK_NULL_HANDLE)
+            vkFreeCommandBuffers(dev, cmd_pool, 1, &batch.gfx_cmd_buf);
+    }
+    free_upload_batches.clear();
+
+    clean_up_buf(staging_ring);
+}
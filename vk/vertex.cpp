@@ -4,27 +4,30 @@
 
 #include "../app.h"
 
-VkVertexInputBindingDescription Vertex::get_binding_desc() {
+VkVertexInputBindingDescription VCW_InstanceData::get_binding_desc() {
     VkVertexInputBindingDescription binding_desc{};
-    binding_desc.binding = 0;
-    binding_desc.stride = sizeof(Vertex);
-    binding_desc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    binding_desc.binding = 1;
+    binding_desc.stride = sizeof(VCW_InstanceData);
+    binding_desc.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
 
     return binding_desc;
 }
 
-std::array<VkVertexInputAttributeDescription, 2> Vertex::get_attrib_descs() {
-    std::array<VkVertexInputAttributeDescription, 2> attrib_descs{};
+// the model matrix takes one location per column
+std::array<VkVertexInputAttributeDescription, 5> VCW_InstanceData::get_attrib_descs() {
+    std::array<VkVertexInputAttributeDescription, 5> attrib_descs{};
 
-    attrib_descs[0].binding = 0;
-    attrib_descs[0].location = 0;
-    attrib_descs[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-    attrib_descs[0].offset = offsetof(Vertex, pos);
+    for (uint32_t i = 0; i < 4; i++) {
+        attrib_descs[i].binding = 1;
+        attrib_descs[i].location = 2 + i;
+        attrib_descs[i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attrib_descs[i].offset = offsetof(VCW_InstanceData, model) + i * sizeof(glm::vec4);
+    }
 
-    attrib_descs[1].binding = 0;
-    attrib_descs[1].location = 1;
-    attrib_descs[1].format = VK_FORMAT_R32G32_SFLOAT;
-    attrib_descs[1].offset = offsetof(Vertex, uv);
+    attrib_descs[4].binding = 1;
+    attrib_descs[4].location = 6;
+    attrib_descs[4].format = VK_FORMAT_R32_UINT;
+    attrib_descs[4].offset = offsetof(VCW_InstanceData, material);
 
     return attrib_descs;
 }